@@ -3,6 +3,11 @@
 #include "kern/mm/mmu.h"
 #include "kern/debug/kmonitor.h"
 #include "kern/debug/kdebug.h"
+#include "kern/process/proc.h"
+#include "kern/mm/swap.h"
+#include "kern/schedule/sched.h"
+#include "kern/schedule/sched_trace.h"
+#include "libs/x86.h"
 
 /* *
  * Simple command-line kernel monitor useful for controlling the
@@ -21,6 +26,12 @@ static struct command commands[] = {
     {"help", "Display this list of commands.", mon_help},
     {"kerninfo", "Display information about the kernel.", mon_kerninfo},
     {"backtrace", "Print backtrace of stack frame.", mon_backtrace},
+    {"swapstat", "Display swap statistics and per-process faults.", mon_swapstat},
+    {"schedbench", "Benchmark run queue operations of sched classes [n].", mon_schedbench},
+    {"schedtrace", "Dump the last scheduler events [n], or on/off/clear tracing.", mon_schedtrace},
+    {"schedhist", "Display wakeup latency, time slice and run queue histograms.", mon_schedhist},
+    {"proccache", "Display hit rates of the proc_struct and kernel stack caches.", mon_proccache},
+    {"ps", "Display the processes with their cpu time and resource usage.", mon_ps},
 };
 
 /* return if kernel is panic, in kern/debug/panic.c */
@@ -144,3 +155,135 @@ int mon_backtrace(int argc, char **argv, struct trap_frame *tf)
     print_stackframe();
     return 0;
 }
+
+/* *
+ * mon_swapstat - print the global swap counters, then the fault and
+ * swap counters of every process which owns an mm.
+ * */
+int mon_swapstat(int argc, char **argv, struct trap_frame *tf)
+{
+    struct swapstat stat;
+    swap_stat(NULL, &stat);
+    cprintf("swap slots: %d/%d used, zswap: %d pages in %d bytes\n",
+            stat.ss_slots_used, stat.ss_slots_total, stat.ss_zswap_pages, stat.ss_zswap_bytes);
+    cprintf("swap io: read %llu bytes, write %llu bytes\n", stat.ss_read_bytes, stat.ss_write_bytes);
+    cprintf("swap in: %d times, avg latency %d ticks\n", stat.ss_swapin_total, stat.ss_swapin_ticks);
+
+    cprintf("%5s %-16s %8s %8s %8s %8s\n", "pid", "name", "minflt", "majflt", "swapin", "swapout");
+    list_entry_t *list = &g_proc_list, *le = list;
+    while ((le = list_next(le)) != list)
+    {
+        struct proc_struct *proc = le2proc(le, list_link);
+        if (proc->mm != NULL)
+        {
+            struct mm_struct *mm = proc->mm;
+            cprintf("%5d %-16s %8d %8d %8d %8d\n", proc->pid, proc->name,
+                    mm->n_minflt, mm->n_majflt, mm->n_swapin, mm->n_swapout);
+        }
+    }
+    return 0;
+}
+
+/* *
+ * mon_schedbench - call sched_bench with the number of runnable processes,
+ * 1000 by default
+ * */
+int mon_schedbench(int argc, char **argv, struct trap_frame *tf)
+{
+    int n = (argc > 0) ? strtol(argv[0], NULL, 10) : 1000;
+    int ret;
+    if ((ret = sched_bench(n)) != 0)
+    {
+        cprintf("schedbench failed: %e.\n", ret);
+    }
+    return 0;
+}
+
+/* *
+ * mon_schedtrace - print the last n scheduler events, 50 by default, or
+ * turn tracing on/off, or clear the trace buffers
+ * */
+int mon_schedtrace(int argc, char **argv, struct trap_frame *tf)
+{
+    if (argc > 0 && strcmp(argv[0], "on") == 0)
+    {
+        g_sched_trace_on = 1;
+    }
+    else if (argc > 0 && strcmp(argv[0], "off") == 0)
+    {
+        g_sched_trace_on = 0;
+    }
+    else if (argc > 0 && strcmp(argv[0], "clear") == 0)
+    {
+        sched_trace_clear();
+    }
+    else
+    {
+        sched_trace_dump((argc > 0) ? strtol(argv[0], NULL, 10) : 50);
+    }
+    return 0;
+}
+
+/* mon_schedhist - compute the histograms from the scheduler events */
+int mon_schedhist(int argc, char **argv, struct trap_frame *tf)
+{
+    sched_trace_hist();
+    return 0;
+}
+
+// 命中率，保留一位小数
+static void print_hit_rate(const char *name, uint32_t hits, uint32_t misses, int cached)
+{
+    uint32_t total = hits + misses;
+    uint64_t permille = (uint64_t)hits * 1000;
+    if (total != 0)
+    {
+        do_div(permille, total);
+    }
+    cprintf("%-7s %10u %10u %5u.%u%% %7d\n", name, hits, misses,
+            (uint32_t)permille / 10, (uint32_t)permille % 10, cached);
+}
+
+/* mon_proccache - print how often fork found a free proc_struct and kernel stack in the caches */
+int mon_proccache(int argc, char **argv, struct trap_frame *tf)
+{
+    struct proc_cache_stat stat;
+    proc_cache_stat(&stat);
+    cprintf("%-7s %10s %10s %7s %7s\n", "cache", "hits", "misses", "rate", "cached");
+    print_hit_rate("proc", stat.proc_hits, stat.proc_misses, stat.procs_cached);
+    print_hit_rate("kstack", stat.kstack_hits, stat.kstack_misses, stat.kstacks_cached);
+    return 0;
+}
+
+static const char *proc_state_names[] = {
+    [PROC_UNINIT] = "U",
+    [PROC_SLEEPING] = "S",
+    [PROC_RUNNABLE] = "R",
+    [PROC_ZOMBIE] = "Z",
+};
+
+/* *
+ * mon_ps - list every process with its user and system ticks, context
+ * switches, page faults and file I/O. The children columns add up what the
+ * reaped descendants of the process used, so load that came and went can
+ * still be attributed to the process which started it.
+ * */
+int mon_ps(int argc, char **argv, struct trap_frame *tf)
+{
+    cprintf("%5s %5s %2s %7s %7s %7s %7s %7s %7s %9s %9s %7s %7s  %s\n",
+            "pid", "ppid", "st", "utime", "stime", "nvcsw", "nivcsw", "minflt", "majflt",
+            "read_kb", "write_kb", "c_utime", "c_stime", "name");
+    list_entry_t *list = &g_proc_list, *le = list;
+    while ((le = list_next(le)) != list)
+    {
+        struct proc_struct *proc = le2proc(le, list_link);
+        struct rusage ru;
+        proc_rusage(proc, &ru);
+        cprintf("%5d %5d %2s %7u %7u %7u %7u %7u %7u %9u %9u %7u %7u  %s\n",
+                proc->pid, (proc->parent != NULL) ? proc->parent->pid : 0, proc_state_names[proc->state],
+                ru.ru_utime, ru.ru_stime, ru.ru_nvcsw, ru.ru_nivcsw, ru.ru_minflt, ru.ru_majflt,
+                (uint32_t)(ru.ru_read_bytes >> 10), (uint32_t)(ru.ru_write_bytes >> 10),
+                proc->child_rusage.ru_utime, proc->child_rusage.ru_stime, proc->name);
+    }
+    return 0;
+}
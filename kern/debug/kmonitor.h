@@ -8,6 +8,12 @@ void kmonitor(struct trap_frame *tf);
 int mon_help(int argc, char **argv, struct trap_frame *tf);
 int mon_kerninfo(int argc, char **argv, struct trap_frame *tf);
 int mon_backtrace(int argc, char **argv, struct trap_frame *tf);
+int mon_swapstat(int argc, char **argv, struct trap_frame *tf);
+int mon_schedbench(int argc, char **argv, struct trap_frame *tf);
+int mon_schedtrace(int argc, char **argv, struct trap_frame *tf);
+int mon_schedhist(int argc, char **argv, struct trap_frame *tf);
+int mon_proccache(int argc, char **argv, struct trap_frame *tf);
+int mon_ps(int argc, char **argv, struct trap_frame *tf);
 int mon_continue(int argc, char **argv, struct trap_frame *tf);
 int mon_step(int argc, char **argv, struct trap_frame *tf);
 int mon_breakpoint(int argc, char **argv, struct trap_frame *tf);
@@ -2,9 +2,11 @@
 #include "libs/x86.h"
 #include "kern/driver/stdio.h"
 #include "kern/driver/picirq.h"
+#include "kern/driver/clock.h"
 
 // 8253可编程定时器，对应IRQ0中断
 #define IO_TIMER1 0x040
+#define IO_TIMER2 0x042
 
 // TIMER_FREQ/freq的值等于产生频率为freq的定时器的初始值
 #define TIMER_FREQ 1193182
@@ -19,30 +21,149 @@
 // SC：使用内部的哪个计数器（有0，1，2三个内部计数器）
 // RL：读写模式，00计数器锁存；01只读写高8位；10只读写低8位；11先读写高8位，再读写低8位。
 // Mode：操作模式，一般采用模式2，计数到0之后自动装载初始值重新开始计数
+//       模式0计数到0的时候产生一次中断，之后就不再产生中断，直到重新写入初始值
 // BCD：使用二进制，还是BCD码
 //
 #define TIMER_MODE (IO_TIMER1 + 3) // timer mode port
 #define TIMER_SEL0 0x00            // select counter 0
+#define TIMER_SEL2 0x80            // select counter 2
+#define TIMER_INTTC 0x00           // mode 0, intr on terminal cnt
 #define TIMER_RATEGEN 0x04         // mode 2, rate generator
 #define TIMER_16BIT 0x30           // r/w counter 16 bits, LSB first
 
+// 2号计数器的门控和输出在这个端口上
+#define IO_PPI 0x061
+#define PPI_TIMER2_GATE 0x01
+#define PPI_SPKR 0x02
+#define PPI_TIMER2_OUT 0x20
+
+#define TICK_DIV TIMER_DIV(TICK_HZ)
+
 volatile size_t g_ticks;
 
-// 初始化定时器，频率为100hz
+static uint32_t g_tsc_per_tick; // 每个tick的tsc周期数，为0时不停掉时钟
+static uint64_t g_tick_tsc;     // 最近一个tick对应的tsc
+static bool g_clock_stopped;    // 空闲时时钟改成了单次模式
+
+// 用2号计数器定一个tick的时间，测出这段时间里的tsc周期数
+static uint32_t clock_calibrate_tsc(void)
+{
+    outb(IO_PPI, (inb(IO_PPI) & ~PPI_SPKR) | PPI_TIMER2_GATE);
+    outb(TIMER_MODE, TIMER_SEL2 | TIMER_INTTC | TIMER_16BIT);
+    outb(IO_TIMER2, TICK_DIV % 256);
+    outb(IO_TIMER2, TICK_DIV / 256);
+
+    uint64_t start = rdtsc();
+    while ((inb(IO_PPI) & PPI_TIMER2_OUT) == 0)
+    {
+        /* do nothing */;
+    }
+    uint64_t cycles = rdtsc() - start;
+    return (cycles >> 32) != 0 ? 0 : cycles;
+}
+
+// 周期模式，每个tick产生一次中断
+static void clock_set_periodic(void)
+{
+    outb(TIMER_MODE, TIMER_SEL0 | TIMER_RATEGEN | TIMER_16BIT);
+    outb(IO_TIMER1, TICK_DIV % 256);
+    outb(IO_TIMER1, TICK_DIV / 256);
+}
+
+// 初始化定时器，频率为TICK_HZ
 void clock_init(void)
 {
+    g_tsc_per_tick = clock_calibrate_tsc();
+
     // set 8253 timer-chip
-    outb(TIMER_MODE, TIMER_SEL0 | TIMER_RATEGEN | TIMER_16BIT);
-    outb(IO_TIMER1, TIMER_DIV(100) % 256);
-    outb(IO_TIMER1, TIMER_DIV(100) / 256);
+    clock_set_periodic();
 
     // initialize time counter 'ticks' to zero
     g_ticks = 0;
+    g_tick_tsc = rdtsc();
 
     // 允许定时器中断
     pic_enable(IRQ_TIMER);
 
-    cprintf("++ setup timer interrupts\n");
+    cprintf("++ setup timer interrupts, %u tsc cycles per tick\n", g_tsc_per_tick);
+}
+
+/* *
+ * clock_set_next_event - stop the periodic tick when the CPU goes idle
+ * @ticks:  the number of ticks until the next timer, 0 if there isn't any
+ *
+ * The counter is switched to one-shot mode. With @ticks == 0 it's left
+ * without a count and won't interrupt at all; otherwise it fires once after
+ * @ticks, bounded by the 16 bits counter (about 5 ticks). The elapsed ticks
+ * are counted with the tsc in clock_resume(). Must be called with interrupts
+ * disabled.
+ * */
+void clock_set_next_event(size_t ticks)
+{
+    if (g_tsc_per_tick == 0 || g_clock_stopped)
+    {
+        return;
+    }
+    g_clock_stopped = 1;
+    outb(TIMER_MODE, TIMER_SEL0 | TIMER_INTTC | TIMER_16BIT);
+    if (ticks != 0)
+    {
+        uint32_t count = (ticks < 0xFFFF / TICK_DIV) ? ticks * TICK_DIV : 0xFFFF;
+        outb(IO_TIMER1, count % 256);
+        outb(IO_TIMER1, count / 256);
+    }
+}
+
+// 从单次模式恢复成周期模式，把停掉的这段时间补到g_ticks上
+void clock_resume(void)
+{
+    if (!g_clock_stopped)
+    {
+        return;
+    }
+    uint64_t elapsed = rdtsc() - g_tick_tsc;
+    do_div(elapsed, g_tsc_per_tick);
+    g_ticks += elapsed;
+    g_tick_tsc += elapsed * g_tsc_per_tick;
+    clock_set_periodic();
+    g_clock_stopped = 0;
+}
+
+// 时钟中断的处理，更新g_ticks
+void clock_tick(void)
+{
+    if (g_clock_stopped)
+    {
+        clock_resume();
+        return;
+    }
+    g_ticks++;
+    g_tick_tsc = rdtsc();
+}
+
+uint32_t clock_tsc_per_tick(void)
+{
+    return g_tsc_per_tick;
+}
+
+// 忙等us微秒，tsc没测出来的话就按读一次端口大约1us来估算
+void clock_udelay(uint32_t us)
+{
+    if (g_tsc_per_tick == 0)
+    {
+        while (us-- > 0)
+        {
+            inb(0x84);
+        }
+        return;
+    }
+    uint64_t cycles = (uint64_t)g_tsc_per_tick * TICK_HZ * us;
+    do_div(cycles, 1000000);
+    uint64_t start = rdtsc();
+    while (rdtsc() - start < cycles)
+    {
+        /* do nothing */;
+    }
 }
 
 // 获取当前的系统时间
@@ -3,11 +3,28 @@
 
 #include "libs/defs.h"
 
+#define TICK_HZ 100 // 每秒的tick数
+
 extern volatile size_t g_ticks;
 
 // 初始化定时器
 void clock_init(void);
 
+// 时钟中断的处理
+void clock_tick(void);
+
+// 空闲时停掉周期时钟，只在下一个定时器到期时产生中断
+void clock_set_next_event(size_t ticks);
+
+// 恢复周期时钟
+void clock_resume(void);
+
+// 每个tick的tsc周期数，没测出来时为0
+uint32_t clock_tsc_per_tick(void);
+
+// 忙等us微秒
+void clock_udelay(uint32_t us);
+
 // 获取当前的系统时间
 long system_read_timer(void);
 
@@ -0,0 +1,61 @@
+#include "kern/driver/ioapic.h"
+#include "kern/driver/picirq.h"
+#include "kern/driver/stdio.h"
+#include "kern/mm/pmm.h"
+
+/* *
+ * IOAPIC
+ *
+ * 外部中断还是由8259A通过BSP的LINT0送进来（虚拟线模式），时钟中断和键盘
+ * 中断都只在BSP上处理，所以IOAPIC的所有管脚都屏蔽掉，避免同一个IRQ从两条
+ * 路径重复送达。
+ * */
+
+#define IOAPIC_REGSEL 0x00 // 寄存器选择
+#define IOAPIC_WIN 0x10    // 寄存器数据窗口
+
+#define IOAPIC_REG_ID 0x00    // ID
+#define IOAPIC_REG_VER 0x01   // 版本，16~23位是最大的重定向表项号
+#define IOAPIC_REG_TABLE 0x10 // 重定向表，每项两个寄存器
+
+#define IOAPIC_INT_DISABLED 0x00010000
+
+uintptr_t g_ioapic_pa;
+uint8_t g_ioapic_id;
+
+static volatile uint32_t *g_ioapic;
+
+static uint32_t ioapic_read(int reg)
+{
+    g_ioapic[IOAPIC_REGSEL / 4] = reg;
+    return g_ioapic[IOAPIC_WIN / 4];
+}
+
+static void ioapic_write(int reg, uint32_t data)
+{
+    g_ioapic[IOAPIC_REGSEL / 4] = reg;
+    g_ioapic[IOAPIC_WIN / 4] = data;
+}
+
+// 初始化IOAPIC，屏蔽所有管脚
+void ioapic_init(void)
+{
+    if (g_ioapic_pa == 0)
+    {
+        return;
+    }
+    g_ioapic = mmio_map(g_ioapic_pa, PG_SIZE);
+
+    int max_intr = (ioapic_read(IOAPIC_REG_VER) >> 16) & 0xFF;
+    int id = ioapic_read(IOAPIC_REG_ID) >> 24;
+    if (id != g_ioapic_id)
+    {
+        cprintf("ioapic: id %d isn't the %d in mp table.\n", id, g_ioapic_id);
+    }
+
+    for (int i = 0; i <= max_intr; i++)
+    {
+        ioapic_write(IOAPIC_REG_TABLE + 2 * i, IOAPIC_INT_DISABLED | (IRQ_OFFSET + i));
+        ioapic_write(IOAPIC_REG_TABLE + 2 * i + 1, 0);
+    }
+}
@@ -0,0 +1,11 @@
+#ifndef __KERN_DRIVER_IOAPIC_H__
+#define __KERN_DRIVER_IOAPIC_H__
+
+#include "libs/defs.h"
+
+extern uintptr_t g_ioapic_pa; // IOAPIC寄存器的物理地址，没有IOAPIC时为0
+extern uint8_t g_ioapic_id;   // IOAPIC的ID
+
+void ioapic_init(void);
+
+#endif /* !__KERN_DRIVER_IOAPIC_H__ */
@@ -0,0 +1,215 @@
+#include "kern/driver/lapic.h"
+#include "kern/driver/clock.h"
+#include "kern/driver/stdio.h"
+#include "kern/mm/pmm.h"
+#include "kern/trap/trap.h"
+#include "kern/process/cpu.h"
+#include "libs/x86.h"
+
+/* *
+ * local APIC
+ *
+ * 每个CPU都有一个local APIC，寄存器映射在同一个物理地址上，各个CPU访问到的
+ * 是自己的那个。BSP的8259A仍然通过LINT0（ExtINT，虚拟线模式）送中断，AP
+ * 用local APIC的定时器产生时钟中断，CPU之间用IPI互相通知。
+ * */
+
+// 寄存器偏移，按字节
+#define LAPIC_ID 0x020    // ID
+#define LAPIC_VER 0x030   // 版本
+#define LAPIC_TPR 0x080   // 任务优先级
+#define LAPIC_EOI 0x0B0   // 中断结束
+#define LAPIC_SVR 0x0F0   // 伪中断向量
+#define LAPIC_ENABLE 0x00000100
+#define LAPIC_ESR 0x280   // 错误状态
+#define LAPIC_ICRLO 0x300 // 中断命令，低32位
+#define LAPIC_INIT 0x00000500
+#define LAPIC_STARTUP 0x00000600
+#define LAPIC_DELIVS 0x00001000
+#define LAPIC_ASSERT 0x00004000
+#define LAPIC_LEVEL 0x00008000
+#define LAPIC_BCAST 0x00080000 // 发给包括自己在内的所有CPU
+#define LAPIC_ICRHI 0x310 // 中断命令，高32位
+#define LAPIC_TIMER 0x320 // LVT定时器
+#define LAPIC_PERIODIC 0x00020000
+#define LAPIC_PCINT 0x340 // LVT性能计数器
+#define LAPIC_LINT0 0x350 // LVT LINT0
+#define LAPIC_LINT1 0x360 // LVT LINT1
+#define LAPIC_EXTINT 0x00000700
+#define LAPIC_NMI 0x00000400
+#define LAPIC_ERROR 0x370 // LVT错误
+#define LAPIC_MASKED 0x00010000
+#define LAPIC_TICR 0x380 // 定时器初始计数
+#define LAPIC_TCCR 0x390 // 定时器当前计数
+#define LAPIC_TDCR 0x3E0 // 定时器分频
+#define LAPIC_X1 0x0000000B
+
+// CMOS的关机状态字节，设为0x0A时热重启会跳到0x40:0x67里的地址
+#define IO_RTC 0x70
+#define CMOS_SHUTDOWN 0x0F
+#define CMOS_JMP_DWORD 0x0A
+
+uintptr_t g_lapic_pa;
+static volatile uint32_t *g_lapic;
+static uint32_t g_lapic_ticks_per_tick; // 一个tick里local APIC定时器的计数
+
+static inline uint32_t lapic_read(int reg)
+{
+    return g_lapic[reg / 4];
+}
+
+static inline void lapic_write(int reg, uint32_t value)
+{
+    g_lapic[reg / 4] = value;
+    // 读一下ID寄存器，等写操作完成
+    g_lapic[LAPIC_ID / 4];
+}
+
+// 用tsc定出一个tick的时间，测出local APIC定时器在这段时间里的计数
+static uint32_t lapic_calibrate(void)
+{
+    uint32_t tsc_per_tick = clock_tsc_per_tick();
+    if (tsc_per_tick == 0)
+    {
+        return 10000000;
+    }
+    lapic_write(LAPIC_TDCR, LAPIC_X1);
+    lapic_write(LAPIC_TIMER, LAPIC_MASKED | T_LAPIC_TIMER);
+    lapic_write(LAPIC_TICR, 0xFFFFFFFF);
+    uint64_t start = rdtsc();
+    while (rdtsc() - start < tsc_per_tick)
+    {
+        /* do nothing */;
+    }
+    uint32_t count = 0xFFFFFFFF - lapic_read(LAPIC_TCCR);
+    lapic_write(LAPIC_TICR, 0);
+    return count;
+}
+
+/* *
+ * lapic_init - enable the local APIC of the current CPU. The first call is on
+ * the BSP: it maps the registers, keeps the 8259A in virtual wire mode through
+ * LINT0 and leaves the timer to the PIT. APs get a periodic local APIC timer
+ * of TICK_HZ instead, calibrated once by the BSP.
+ * */
+void lapic_init(void)
+{
+    if (g_lapic_pa == 0)
+    {
+        return;
+    }
+    if (g_lapic == NULL)
+    {
+        g_lapic = mmio_map(g_lapic_pa, PG_SIZE);
+    }
+
+    bool bsp = (this_cpu()->id == 0);
+
+    lapic_write(LAPIC_SVR, LAPIC_ENABLE | T_LAPIC_SPURIOUS);
+
+    if (bsp)
+    {
+        g_lapic_ticks_per_tick = lapic_calibrate();
+        lapic_write(LAPIC_TIMER, LAPIC_MASKED | T_LAPIC_TIMER);
+        lapic_write(LAPIC_LINT0, LAPIC_EXTINT);
+        lapic_write(LAPIC_LINT1, LAPIC_NMI);
+    }
+    else
+    {
+        lapic_write(LAPIC_TDCR, LAPIC_X1);
+        lapic_write(LAPIC_TIMER, LAPIC_PERIODIC | T_LAPIC_TIMER);
+        lapic_write(LAPIC_TICR, g_lapic_ticks_per_tick);
+        lapic_write(LAPIC_LINT0, LAPIC_MASKED);
+        lapic_write(LAPIC_LINT1, LAPIC_MASKED);
+    }
+
+    // 有性能计数器中断的话也屏蔽掉
+    if (((lapic_read(LAPIC_VER) >> 16) & 0xFF) >= 4)
+    {
+        lapic_write(LAPIC_PCINT, LAPIC_MASKED);
+    }
+
+    lapic_write(LAPIC_ERROR, T_LAPIC_ERROR);
+
+    // 清掉错误状态，要连写两次
+    lapic_write(LAPIC_ESR, 0);
+    lapic_write(LAPIC_ESR, 0);
+
+    // 确认掉可能残留的中断
+    lapic_write(LAPIC_EOI, 0);
+
+    // 同步所有local APIC的仲裁ID
+    lapic_write(LAPIC_ICRHI, 0);
+    lapic_write(LAPIC_ICRLO, LAPIC_BCAST | LAPIC_INIT | LAPIC_LEVEL);
+    while (lapic_read(LAPIC_ICRLO) & LAPIC_DELIVS)
+    {
+        /* do nothing */;
+    }
+
+    // 接收所有优先级的中断
+    lapic_write(LAPIC_TPR, 0);
+}
+
+// 获取当前CPU的local APIC ID
+int lapic_id(void)
+{
+    if (g_lapic == NULL)
+    {
+        return 0;
+    }
+    return lapic_read(LAPIC_ID) >> 24;
+}
+
+// 通知local APIC中断处理完了
+void lapic_eoi(void)
+{
+    if (g_lapic != NULL)
+    {
+        lapic_write(LAPIC_EOI, 0);
+    }
+}
+
+static void lapic_send_icr(int apic_id, uint32_t icr)
+{
+    lapic_write(LAPIC_ICRHI, apic_id << 24);
+    lapic_write(LAPIC_ICRLO, icr);
+    while (lapic_read(LAPIC_ICRLO) & LAPIC_DELIVS)
+    {
+        /* do nothing */;
+    }
+}
+
+// 给apic_id对应的CPU发送一个向量为vector的IPI
+void lapic_send_ipi(int apic_id, int vector)
+{
+    if (g_lapic != NULL)
+    {
+        lapic_send_icr(apic_id, vector);
+    }
+}
+
+/* *
+ * lapic_start_ap - start the AP @apic_id at the real mode code at @entry_pa
+ * with the INIT-SIPI-SIPI sequence of the MultiProcessor Specification.
+ * */
+void lapic_start_ap(int apic_id, uintptr_t entry_pa)
+{
+    // 老的CPU收到INIT后会走BIOS的热重启，让它直接跳到entry_pa
+    outb(IO_RTC, CMOS_SHUTDOWN);
+    outb(IO_RTC + 1, CMOS_JMP_DWORD);
+    uint16_t *warm_reset = (uint16_t *)KADDR((0x40 << 4) | 0x67);
+    warm_reset[0] = 0;
+    warm_reset[1] = entry_pa >> 4;
+
+    lapic_send_icr(apic_id, LAPIC_INIT | LAPIC_LEVEL | LAPIC_ASSERT);
+    clock_udelay(200);
+    lapic_send_icr(apic_id, LAPIC_INIT | LAPIC_LEVEL);
+    clock_udelay(10000);
+
+    // 新的CPU只认STARTUP，规范要求发两次
+    for (int i = 0; i < 2; i++)
+    {
+        lapic_send_icr(apic_id, LAPIC_STARTUP | (entry_pa >> 12));
+        clock_udelay(200);
+    }
+}
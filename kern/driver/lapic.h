@@ -0,0 +1,14 @@
+#ifndef __KERN_DRIVER_LAPIC_H__
+#define __KERN_DRIVER_LAPIC_H__
+
+#include "libs/defs.h"
+
+extern uintptr_t g_lapic_pa; // local APIC寄存器的物理地址，没有APIC时为0
+
+void lapic_init(void);
+int lapic_id(void);
+void lapic_eoi(void);
+void lapic_send_ipi(int apic_id, int vector);
+void lapic_start_ap(int apic_id, uintptr_t entry_pa);
+
+#endif /* !__KERN_DRIVER_LAPIC_H__ */
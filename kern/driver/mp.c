@@ -0,0 +1,335 @@
+#include "kern/driver/mp.h"
+#include "kern/driver/lapic.h"
+#include "kern/driver/ioapic.h"
+#include "kern/driver/stdio.h"
+#include "kern/process/cpu.h"
+#include "kern/mm/mem_layout.h"
+#include "libs/x86.h"
+#include "libs/string.h"
+
+/* *
+ * 多处理器信息的探测
+ *
+ * 先找ACPI的MADT表，找不到再找Intel MP规范里的MP配置表，两者都是BIOS放在
+ * 物理内存里的。BSP总是g_cpus[0]，其它启用的CPU按表里的顺序排在后面。
+ * */
+
+// ACPI的根系统描述指针，在EBDA的前1KB或者0xE0000~0xFFFFF里，16字节对齐
+struct acpi_rsdp
+{
+    char signature[8]; // "RSD PTR "
+    uint8_t checksum;
+    char oem_id[6];
+    uint8_t revision;
+    uint32_t rsdt_addr; // RSDT的物理地址
+} __attribute__((packed));
+
+// ACPI表的公共表头
+struct acpi_header
+{
+    char signature[4];
+    uint32_t length; // 包括表头在内的整个表的长度
+    uint8_t revision;
+    uint8_t checksum;
+    char oem_id[6];
+    char oem_table_id[8];
+    uint32_t oem_revision;
+    uint32_t creator_id;
+    uint32_t creator_revision;
+} __attribute__((packed));
+
+// MADT，表头后面跟着变长的表项
+struct acpi_madt
+{
+    struct acpi_header header; // "APIC"
+    uint32_t lapic_addr;       // local APIC的物理地址
+    uint32_t flags;
+} __attribute__((packed));
+
+#define MADT_LAPIC 0  // 一个CPU的local APIC
+#define MADT_IOAPIC 1 // 一个IOAPIC
+#define MADT_LAPIC_ENABLED 0x1
+
+struct madt_entry
+{
+    uint8_t type;
+    uint8_t length;
+    union
+    {
+        struct
+        {
+            uint8_t acpi_id;
+            uint8_t apic_id;
+            uint32_t flags;
+        } __attribute__((packed)) lapic;
+        struct
+        {
+            uint8_t id;
+            uint8_t reserved;
+            uint32_t addr;
+            uint32_t gsi_base;
+        } __attribute__((packed)) ioapic;
+    };
+} __attribute__((packed));
+
+// MP浮点结构，在EBDA的前1KB、基本内存的最后1KB或者0xF0000~0xFFFFF里
+struct mp_fp
+{
+    char signature[4]; // "_MP_"
+    uint32_t conf_addr; // MP配置表的物理地址
+    uint8_t length;     // 以16字节为单位
+    uint8_t spec_rev;
+    uint8_t checksum;
+    uint8_t type; // 非0表示用默认配置，没有配置表
+    uint8_t imcrp;
+    uint8_t reserved[3];
+} __attribute__((packed));
+
+// MP配置表的表头，后面跟着变长的表项
+struct mp_conf
+{
+    char signature[4]; // "PCMP"
+    uint16_t length;   // 包括表头在内的整个表的长度
+    uint8_t version;
+    uint8_t checksum;
+    char product[20];
+    uint32_t oem_table;
+    uint16_t oem_length;
+    uint16_t entry;      // 表项数量
+    uint32_t lapic_addr; // local APIC的物理地址
+    uint16_t xlength;
+    uint8_t xchecksum;
+    uint8_t reserved;
+} __attribute__((packed));
+
+#define MPPROC 0x00   // 一个CPU，20字节
+#define MPBUS 0x01    // 一条总线，8字节
+#define MPIOAPIC 0x02 // 一个IOAPIC，8字节
+#define MPIOINTR 0x03 // IO中断分配，8字节
+#define MPLINTR 0x04  // 本地中断分配，8字节
+
+#define MPPROC_ENABLED 0x01
+
+struct mp_proc
+{
+    uint8_t type;
+    uint8_t apic_id;
+    uint8_t version;
+    uint8_t flags;
+    uint8_t signature[4];
+    uint32_t feature;
+    uint8_t reserved[8];
+} __attribute__((packed));
+
+struct mp_ioapic
+{
+    uint8_t type;
+    uint8_t apic_id;
+    uint8_t version;
+    uint8_t flags;
+    uint32_t addr;
+} __attribute__((packed));
+
+// 按字节求和，校验和正确的话结果为0
+static uint8_t mp_sum(void *addr, size_t len)
+{
+    uint8_t sum = 0;
+    for (size_t i = 0; i < len; i++)
+    {
+        sum += ((uint8_t *)addr)[i];
+    }
+    return sum;
+}
+
+// 表必须在内核映射的物理内存里才能访问
+static void *mp_kaddr(uintptr_t pa, size_t len)
+{
+    if (pa == 0 || pa + len < pa || pa + len > KMEM_SIZE)
+    {
+        return NULL;
+    }
+    return KADDR(pa);
+}
+
+// 在物理地址[pa, pa + len)里按16字节对齐查找签名为sig、校验和正确的结构
+static void *mp_search_range(uintptr_t pa, size_t len, const char *sig, size_t sig_len, size_t size)
+{
+    for (uintptr_t p = pa; p + size <= pa + len; p += 16)
+    {
+        void *addr = KADDR(p);
+        if (memcmp(addr, sig, sig_len) == 0 && mp_sum(addr, size) == 0)
+        {
+            return addr;
+        }
+    }
+    return NULL;
+}
+
+// 依次在EBDA的前1KB、基本内存的最后1KB和BIOS ROM里查找
+static void *mp_search(const char *sig, size_t sig_len, size_t size, uintptr_t rom_start)
+{
+    void *addr;
+    uintptr_t ebda = *(uint16_t *)KADDR(0x40E) << 4;
+    if (ebda != 0 && (addr = mp_search_range(ebda, 1024, sig, sig_len, size)) != NULL)
+    {
+        return addr;
+    }
+    uintptr_t base_end = *(uint16_t *)KADDR(0x413) * 1024;
+    if (base_end >= 1024 && (addr = mp_search_range(base_end - 1024, 1024, sig, sig_len, size)) != NULL)
+    {
+        return addr;
+    }
+    return mp_search_range(rom_start, 0x100000 - rom_start, sig, sig_len, size);
+}
+
+// 添加一个AP，BSP已经在g_cpus[0]了
+static void mp_add_cpu(int apic_id)
+{
+    if (apic_id == g_cpus[0].apic_id)
+    {
+        return;
+    }
+    if (g_ncpu == NCPU)
+    {
+        cprintf("mp: too many cpus, cpu with apic id %d ignored.\n", apic_id);
+        return;
+    }
+    g_cpus[g_ncpu].id = g_ncpu;
+    g_cpus[g_ncpu].apic_id = apic_id;
+    g_ncpu++;
+}
+
+// 解析ACPI的MADT
+static bool mp_parse_acpi(void)
+{
+    struct acpi_rsdp *rsdp = mp_search("RSD PTR ", 8, sizeof(struct acpi_rsdp), 0xE0000);
+    if (rsdp == NULL)
+    {
+        return 0;
+    }
+    struct acpi_header *rsdt = mp_kaddr(rsdp->rsdt_addr, sizeof(struct acpi_header));
+    if (rsdt == NULL || mp_kaddr(rsdp->rsdt_addr, rsdt->length) == NULL ||
+        memcmp(rsdt->signature, "RSDT", 4) != 0 || mp_sum(rsdt, rsdt->length) != 0)
+    {
+        return 0;
+    }
+
+    // RSDT的表头后面是其它表的物理地址
+    struct acpi_madt *madt = NULL;
+    uint32_t *tables = (uint32_t *)(rsdt + 1);
+    int n_tables = (rsdt->length - sizeof(struct acpi_header)) / sizeof(uint32_t);
+    for (int i = 0; i < n_tables && madt == NULL; i++)
+    {
+        struct acpi_header *header = mp_kaddr(tables[i], sizeof(struct acpi_header));
+        if (header != NULL && memcmp(header->signature, "APIC", 4) == 0 &&
+            mp_kaddr(tables[i], header->length) != NULL && mp_sum(header, header->length) == 0)
+        {
+            madt = (struct acpi_madt *)header;
+        }
+    }
+    if (madt == NULL)
+    {
+        return 0;
+    }
+
+    g_lapic_pa = madt->lapic_addr;
+    uint8_t *p = (uint8_t *)(madt + 1), *end = (uint8_t *)madt + madt->header.length;
+    while (p + 2 <= end)
+    {
+        struct madt_entry *entry = (struct madt_entry *)p;
+        if (entry->length < 2)
+        {
+            break;
+        }
+        switch (entry->type)
+        {
+        case MADT_LAPIC:
+            if (entry->lapic.flags & MADT_LAPIC_ENABLED)
+            {
+                mp_add_cpu(entry->lapic.apic_id);
+            }
+            break;
+        case MADT_IOAPIC:
+            if (g_ioapic_pa == 0)
+            {
+                g_ioapic_id = entry->ioapic.id;
+                g_ioapic_pa = entry->ioapic.addr;
+            }
+            break;
+        }
+        p += entry->length;
+    }
+    return 1;
+}
+
+// 解析MP配置表
+static bool mp_parse_mptable(void)
+{
+    struct mp_fp *fp = mp_search("_MP_", 4, sizeof(struct mp_fp), 0xF0000);
+    if (fp == NULL || fp->type != 0)
+    {
+        return 0;
+    }
+    struct mp_conf *conf = mp_kaddr(fp->conf_addr, sizeof(struct mp_conf));
+    if (conf == NULL || mp_kaddr(fp->conf_addr, conf->length) == NULL ||
+        memcmp(conf->signature, "PCMP", 4) != 0 || mp_sum(conf, conf->length) != 0 ||
+        (conf->version != 1 && conf->version != 4))
+    {
+        return 0;
+    }
+
+    g_lapic_pa = conf->lapic_addr;
+    uint8_t *p = (uint8_t *)(conf + 1), *end = (uint8_t *)conf + conf->length;
+    for (int i = 0; i < conf->entry && p < end; i++)
+    {
+        switch (*p)
+        {
+        case MPPROC:
+        {
+            struct mp_proc *proc = (struct mp_proc *)p;
+            if (proc->flags & MPPROC_ENABLED)
+            {
+                mp_add_cpu(proc->apic_id);
+            }
+            p += sizeof(struct mp_proc);
+            break;
+        }
+        case MPIOAPIC:
+        {
+            struct mp_ioapic *ioapic = (struct mp_ioapic *)p;
+            if (g_ioapic_pa == 0)
+            {
+                g_ioapic_id = ioapic->apic_id;
+                g_ioapic_pa = ioapic->addr;
+            }
+            p += sizeof(struct mp_ioapic);
+            break;
+        }
+        case MPBUS:
+        case MPIOINTR:
+        case MPLINTR:
+            p += 8;
+            break;
+        default:
+            cprintf("mp: unknown config type %x.\n", *p);
+            return 1;
+        }
+    }
+    return 1;
+}
+
+void mp_init(void)
+{
+    // cpuid里的初始APIC ID就是BSP的local APIC ID
+    uint32_t ebx;
+    cpuid(1, NULL, &ebx, NULL, NULL);
+    g_cpus[0].apic_id = ebx >> 24;
+    g_ncpu = 1;
+
+    if (!mp_parse_acpi() && !mp_parse_mptable())
+    {
+        cprintf("mp: no multiprocessor information, single cpu.\n");
+        return;
+    }
+    cprintf("mp: %d cpus, lapic at 0x%08x, ioapic %d at 0x%08x\n", g_ncpu, g_lapic_pa, g_ioapic_id, g_ioapic_pa);
+}
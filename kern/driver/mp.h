@@ -0,0 +1,7 @@
+#ifndef __KERN_DRIVER_MP_H__
+#define __KERN_DRIVER_MP_H__
+
+// 从ACPI的MADT或者MP配置表里找出所有的CPU和APIC
+void mp_init(void);
+
+#endif /* !__KERN_DRIVER_MP_H__ */
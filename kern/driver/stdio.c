@@ -51,6 +51,15 @@ void cputchar(int c)
     cons_putc(c);
 }
 
+/* cputbuf - writes @len characters of @buf to stdout */
+void cputbuf(const char *buf, size_t len)
+{
+    while (len-- > 0)
+    {
+        cons_putc(*buf++);
+    }
+}
+
 /* *
  * cputs- writes the string pointed by @str to stdout and
  * appends a newline character.
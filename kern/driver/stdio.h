@@ -8,6 +8,7 @@
 int cprintf(const char *fmt, ...);
 int vcprintf(const char *fmt, va_list ap);
 void cputchar(int c);
+void cputbuf(const char *buf, size_t len);
 int cputs(const char *str);
 int getchar(void);
 
@@ -2,6 +2,7 @@
 #include "kern/debug/assert.h"
 #include "kern/fs/devs/dev.h"
 #include "kern/fs/iobuf.h"
+#include "kern/driver/stdio.h"
 #include "kern/fs/vfs/inode.h"
 #include "libs/unistd.h"
 #include "libs/error.h"
@@ -28,11 +29,9 @@ stdout_io(struct device *dev, struct iobuf *iob, bool write)
 {
     if (write)
     {
-        char *data = iob->io_base;
-        for (; iob->io_resid != 0; iob->io_resid--)
-        {
-            cputchar(*data++);
-        }
+        // 整个缓冲区一次输出完
+        cputbuf(iob->io_base, iob->io_resid);
+        iob->io_resid = 0;
         return 0;
     }
     return -E_INVAL;
@@ -112,6 +112,7 @@ struct sfs_fs
 
 struct fs;
 struct inode;
+struct device;
 
 void sfs_init(void);
 int sfs_mount(const char *devname);
@@ -130,5 +131,6 @@ int sfs_sync_freemap(struct sfs_fs *sfs);
 int sfs_clear_block(struct sfs_fs *sfs, uint32_t blkno, uint32_t nblks);
 
 int sfs_load_inode(struct sfs_fs *sfs, struct inode **node_store, uint32_t ino);
+int sfs_bmap_list(struct inode *node, uint32_t nblks, uint32_t *blks_store, struct device **dev_store);
 
 #endif /* !__KERN_FS_SFS_SFS_H__ */
@@ -426,6 +426,51 @@ sfs_bmap_load_nolock(struct sfs_fs *sfs, struct sfs_inode *sin, uint32_t index,
     return 0;
 }
 
+/*
+ * sfs_bmap_list - get the NO. of disk blocks of a regular file, so that the caller
+ *                 (swapfs) can do block io on them directly without sfs_io.
+ *                 the file must be preallocated: no holes in the first nblks blocks
+ * @node:       the inode of the file
+ * @nblks:      the number of blocks wanted, no more than the blocks of the file
+ * @blks_store: store the NO. of disk blocks
+ * @dev_store:  store the device which the file lives in
+ */
+int sfs_bmap_list(struct inode *node, uint32_t nblks, uint32_t *blks_store, struct device **dev_store)
+{
+    if (!check_inode_type(node, sfs_inode))
+    {
+        return -E_INVAL;
+    }
+    struct sfs_fs *sfs = fsop_info(vop_fs(node), sfs);
+    struct sfs_inode *sin = vop_info(node, sfs_inode);
+    int ret = 0;
+    lock_sin(sin);
+    {
+        struct sfs_disk_inode *din = sin->din;
+        if (din->type != SFS_TYPE_FILE || nblks > din->blocks)
+        {
+            ret = -E_INVAL;
+            goto out;
+        }
+        for (uint32_t i = 0; i < nblks; i++)
+        {
+            if ((ret = sfs_bmap_get_nolock(sfs, sin, i, 0, blks_store + i)) != 0)
+            {
+                goto out;
+            }
+            if (blks_store[i] == 0)
+            {
+                ret = -E_INVAL;
+                goto out;
+            }
+        }
+        *dev_store = sfs->dev;
+    }
+out:
+    unlock_sin(sin);
+    return ret;
+}
+
 /*
  * sfs_bmap_truncate_nolock - free the disk block at the end of file
  */
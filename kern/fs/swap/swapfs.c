@@ -4,24 +4,279 @@
 #include "kern/fs/fs.h"
 #include "kern/driver/ide.h"
 #include "kern/mm/pmm.h"
+#include "kern/mm/kmalloc.h"
 #include "kern/debug/assert.h"
+#include "kern/driver/stdio.h"
+#include "kern/sync/sync.h"
+#include "kern/fs/vfs/vfs.h"
+#include "kern/fs/vfs/inode.h"
+#include "kern/fs/devs/dev.h"
+#include "kern/fs/sfs/sfs.h"
+#include "kern/fs/sfs/bitmap.h"
+#include "kern/fs/iobuf.h"
+#include "libs/unistd.h"
+#include "libs/stat.h"
+#include "libs/string.h"
+#include "libs/error.h"
 
+/* *
+ * 交换空间由若干个交换区组成，每个交换区占用swap_entry_t里一段连续的offset：
+ *   - 裸的交换磁盘SWAP_DEV_NO，槽位i对应磁盘上的第i+1页
+ *   - 文件系统里预先分配好的交换文件，启用时把文件的块号表读到内存里，
+ *     之后直接对这些块做块设备io，不再经过sfs_io和inode锁
+ * */
+
+// 一个交换区
+struct swap_area
+{
+    struct inode *node;   // 交换文件，为NULL时是裸的交换磁盘
+    struct device *dev;   // 交换文件所在的块设备
+    uint32_t *blocks;     // 交换文件每个槽位对应的磁盘块号
+    size_t base;          // 第一个槽位的offset
+    size_t n_slots;       // 槽位数
+    struct bitmap *slots; // 空闲槽位的位图
+};
+
+static struct swap_area swap_areas[SWAP_MAX_AREAS];
+static int n_swap_areas;
+
+// 添加一个交换区，offset紧接在前一个交换区后面
+static int swapfs_add_area(struct inode *node, struct device *dev, uint32_t *blocks, size_t n_slots)
+{
+    size_t base = (n_swap_areas == 0) ? 1 : max_swap_offset;
+    if (n_swap_areas == SWAP_MAX_AREAS || base + n_slots >= MAX_SWAP_OFFSET_LIMIT)
+    {
+        return -E_INVAL;
+    }
+
+    struct bitmap *slots;
+    if ((slots = bitmap_create(n_slots)) == NULL)
+    {
+        return -E_NO_MEM;
+    }
+
+    bool intr_flag;
+    local_intr_save(intr_flag);
+    {
+        struct swap_area *area = swap_areas + n_swap_areas;
+        area->node = node;
+        area->dev = dev;
+        area->blocks = blocks;
+        area->base = base;
+        area->n_slots = n_slots;
+        area->slots = slots;
+        max_swap_offset = base + n_slots;
+        n_swap_areas++;
+    }
+    local_intr_restore(intr_flag);
+    return 0;
+}
+
+// 找到entry所在的交换区，swap_offset已经检查过offset不会超出最后一个交换区
+static struct swap_area *swapfs_find_area(swap_entry_t entry)
+{
+    size_t offset = swap_offset(entry);
+    struct swap_area *area = swap_areas;
+    while (offset >= area->base + area->n_slots)
+    {
+        area++;
+    }
+    return area;
+}
+
+// 有交换磁盘的话就把它作为第一个交换区，没有的话只能等swapfs_swapon启用交换文件
 void swapfs_init(void)
 {
     static_assert((PG_SIZE % SECT_SIZE) == 0);
+    max_swap_offset = 0;
     if (!ide_device_valid(SWAP_DEV_NO))
     {
-        panic("swap fs isn't available.\n");
+        cprintf("SWAP: no swap disk, waiting for swap file.\n");
+        return;
+    }
+
+    size_t n_pages = ide_device_size(SWAP_DEV_NO) / PAGE_NSECT;
+    if (n_pages < 2 || swapfs_add_area(NULL, NULL, NULL, n_pages - 1) != 0)
+    {
+        panic("bad swap disk, %d pages.\n", n_pages);
+    }
+}
+
+/* *
+ * swapfs_swapon - add a preallocated file on sfs as a swap area
+ * @path:   the path of the swap file, such as SWAP_FILE
+ *
+ * The block list of the file is mapped once here, and the file is kept open
+ * until shutdown so that its blocks can't be freed under the swap area.
+ * While it is a swap area the file can't be opened for writing, so nobody
+ * can overwrite or truncate the swapped out pages.
+ * */
+int swapfs_swapon(const char *path)
+{
+    // vfs_open会改写路径，先复制一份
+    char *buf;
+    if ((buf = kmalloc(strlen(path) + 1)) == NULL)
+    {
+        return -E_NO_MEM;
+    }
+    strcpy(buf, path);
+
+    int ret;
+    struct inode *node;
+    ret = vfs_open(buf, O_RDWR, &node);
+    kfree(buf);
+    if (ret != 0)
+    {
+        return ret;
+    }
+
+    ret = -E_INVAL;
+    struct stat __stat, *stat = &__stat;
+    if (vop_fstat(node, stat) != 0 || !S_ISREG(stat->st_mode))
+    {
+        goto failed_cleanup_node;
+    }
+
+    size_t n_slots = stat->st_size / PG_SIZE;
+    if (n_slots == 0)
+    {
+        goto failed_cleanup_node;
+    }
+
+    ret = -E_NO_MEM;
+    uint32_t *blocks;
+    if ((blocks = kmalloc(n_slots * sizeof(uint32_t))) == NULL)
+    {
+        goto failed_cleanup_node;
+    }
+
+    // sfs的块大小就是一页，一个块刚好放一个换出的页
+    static_assert(SFS_BLKSIZE == PG_SIZE);
+    struct device *dev;
+    if ((ret = sfs_bmap_list(node, n_slots, blocks, &dev)) != 0)
+    {
+        goto failed_cleanup_blocks;
+    }
+    assert(dev->d_blocksize == PG_SIZE);
+
+    if ((ret = swapfs_add_area(node, dev, blocks, n_slots)) != 0)
+    {
+        goto failed_cleanup_blocks;
+    }
+    node->in_swap = 1;
+    cprintf("SWAP: swap file %s, %d slots.\n", path, n_slots);
+    return 0;
+
+failed_cleanup_blocks:
+    kfree(blocks);
+failed_cleanup_node:
+    vfs_close(node);
+    return ret;
+}
+
+// 关闭所有交换区，在fs_cleanup之前调用，此时应该已经没有换出的页了
+void swapfs_cleanup(void)
+{
+    bool intr_flag;
+    local_intr_save(intr_flag);
+    {
+        max_swap_offset = 0;
+        n_swap_areas = 0;
+    }
+    local_intr_restore(intr_flag);
+
+    for (int i = 0; i < SWAP_MAX_AREAS; i++)
+    {
+        struct swap_area *area = swap_areas + i;
+        if (area->slots != NULL)
+        {
+            bitmap_destroy(area->slots);
+            area->slots = NULL;
+        }
+        if (area->node != NULL)
+        {
+            kfree(area->blocks);
+            area->node->in_swap = 0;
+            vfs_close(area->node);
+            area->node = NULL;
+        }
+    }
+}
+
+// 分配一个交换槽位，没有空闲槽位时返回-E_NO_MEM
+int swapfs_alloc(swap_entry_t *entry_store)
+{
+    int ret = -E_NO_MEM;
+    bool intr_flag;
+    local_intr_save(intr_flag);
+    {
+        for (int i = 0; i < n_swap_areas; i++)
+        {
+            struct swap_area *area = swap_areas + i;
+            uint32_t slot;
+            if (bitmap_alloc(area->slots, &slot) == 0)
+            {
+                *entry_store = (area->base + slot) << 8;
+                ret = 0;
+                break;
+            }
+        }
+    }
+    local_intr_restore(intr_flag);
+    return ret;
+}
+
+// 释放entry占用的交换槽位
+void swapfs_free(swap_entry_t entry)
+{
+    bool intr_flag;
+    local_intr_save(intr_flag);
+    {
+        struct swap_area *area = swapfs_find_area(entry);
+        bitmap_free(area->slots, swap_offset(entry) - area->base);
+    }
+    local_intr_restore(intr_flag);
+}
+
+// 获取所有交换区的槽位总数
+size_t swapfs_n_slots(void)
+{
+    size_t n_slots = 0;
+    for (int i = 0; i < n_swap_areas; i++)
+    {
+        n_slots += swap_areas[i].n_slots;
+    }
+    return n_slots;
+}
+
+static int swapfs_io(swap_entry_t entry, struct page_desc *page, bool write)
+{
+    struct swap_area *area = swapfs_find_area(entry);
+    size_t slot = swap_offset(entry) - area->base;
+    if (area->node == NULL)
+    {
+        if (write)
+        {
+            return ide_write_secs(SWAP_DEV_NO, (slot + 1) * PAGE_NSECT, page2kva(page), PAGE_NSECT);
+        }
+        return ide_read_secs(SWAP_DEV_NO, (slot + 1) * PAGE_NSECT, page2kva(page), PAGE_NSECT);
+    }
+
+    struct iobuf __iob, *iob = iobuf_init(&__iob, page2kva(page), PG_SIZE, area->blocks[slot] * PG_SIZE);
+    int ret;
+    if ((ret = dop_io(area->dev, iob, write)) == 0 && iob->io_resid != 0)
+    {
+        ret = -E_SWAP_FAULT;
     }
-    max_swap_offset = ide_device_size(SWAP_DEV_NO) / (PG_SIZE / SECT_SIZE);
+    return ret;
 }
 
 int swapfs_read(swap_entry_t entry, struct page_desc *page)
 {
-    return ide_read_secs(SWAP_DEV_NO, swap_offset(entry) * PAGE_NSECT, page2kva(page), PAGE_NSECT);
+    return swapfs_io(entry, page, 0);
 }
 
 int swapfs_write(swap_entry_t entry, struct page_desc *page)
 {
-    return ide_write_secs(SWAP_DEV_NO, swap_offset(entry) * PAGE_NSECT, page2kva(page), PAGE_NSECT);
+    return swapfs_io(entry, page, 1);
 }
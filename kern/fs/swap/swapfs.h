@@ -2,8 +2,17 @@
 #define __KERN_FS_SWAP_SWAPFS_H__
 
 #include "kern/mm/mem_layout.h"
+#include "kern/mm/swap.h"
+
+#define SWAP_MAX_AREAS 4          // 最多的交换区个数
+#define SWAP_FILE "disk0:swap"    // 启动时启用的交换文件
 
 void swapfs_init(void);
+int swapfs_swapon(const char *path);
+void swapfs_cleanup(void);
+int swapfs_alloc(swap_entry_t *entry_store);
+void swapfs_free(swap_entry_t entry);
+size_t swapfs_n_slots(void);
 int swapfs_read(swap_entry_t entry, struct page_desc *page);
 int swapfs_write(swap_entry_t entry, struct page_desc *page);
 
@@ -111,6 +111,7 @@ int sysfile_read(int fd, void *base, size_t len)
 
 out:
     kfree(buffer);
+    g_cur_proc->read_bytes += copied;
     if (copied != 0)
     {
         return copied;
@@ -169,6 +170,7 @@ int sysfile_write(int fd, void *base, size_t len)
 
 out:
     kfree(buffer);
+    g_cur_proc->write_bytes += copied;
     if (copied != 0)
     {
         return copied;
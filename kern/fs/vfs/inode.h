@@ -25,6 +25,9 @@ struct iobuf;
  * open_count is managed using VOP_INCOPEN and VOP_DECOPEN by
  * vfs_open() and vfs_close(). Code above the VFS layer should not
  * need to worry about it.
+ *
+ * in_swap is set by swapfs while the inode backs a swap area, and
+ * vfs_open() refuses to open it for writing.
  */
 struct inode
 {
@@ -40,6 +43,7 @@ struct inode
     } in_type;
     int ref_count;
     int open_count;
+    bool in_swap;
     struct fs *in_fs;
     const struct inode_ops *in_ops;
 };
@@ -38,7 +38,7 @@ int vfs_open(char *path, uint32_t open_flags, struct inode **node_store)
 
     if (ret != 0)
     {
-        if (ret == -16 && (create))
+        if (ret == -E_NOENT && (create))
         {
             char *name;
             struct inode *dir;
@@ -46,7 +46,20 @@ int vfs_open(char *path, uint32_t open_flags, struct inode **node_store)
             {
                 return ret;
             }
-            ret = vop_create(dir, name, excl, &node);
+            // 不是所有的文件系统都支持创建文件（比如sfs），没有这个操作就返回错误
+            if (dir->in_ops->vop_create == NULL)
+            {
+                ret = -E_UNIMP;
+            }
+            else
+            {
+                ret = vop_create(dir, name, excl, &node);
+            }
+            vop_ref_dec(dir);
+            if (ret != 0)
+            {
+                return ret;
+            }
         }
         else
             return ret;
@@ -57,6 +70,13 @@ int vfs_open(char *path, uint32_t open_flags, struct inode **node_store)
     }
     assert(node != NULL);
 
+    // 交换区直接读写交换文件的磁盘块，写入或者截断都会破坏换出的页
+    if (can_write && node->in_swap)
+    {
+        vop_ref_dec(node);
+        return -E_BUSY;
+    }
+
     if ((ret = vop_open(node, open_flags)) != 0)
     {
         vop_ref_dec(node);
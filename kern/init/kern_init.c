@@ -8,8 +8,13 @@
 #include "kern/driver/intr.h"
 #include "kern/mm/vmm.h"
 #include "kern/driver/ide.h"
+#include "kern/driver/mp.h"
+#include "kern/driver/lapic.h"
+#include "kern/driver/ioapic.h"
+#include "kern/process/cpu.h"
 #include "kern/process/proc.h"
 #include "kern/schedule/sched.h"
+#include "kern/sync/futex.h"
 
 // 内核入口
 void kern_init(void)
@@ -24,13 +29,23 @@ void kern_init(void)
 
     pmm_init(); // 初始化物理内存管理
 
-    pic_init(); // 初始化中断控制器
-    idt_init(); // 初始化中断描述符表
+    kernel_lock(); // 进入内核态都要持有大内核锁
+    mp_init();     // 找出所有的CPU
+
+    pic_init();   // 初始化中断控制器
+    idt_init();   // 初始化中断描述符表
+    clock_init(); // 初始化定时器
+
+    lapic_init();  // local APIC的定时器要用tsc校准，放在clock_init之后
+    ioapic_init(); // 屏蔽IOAPIC，外部中断仍然走8259A
 
     sched_init(); // 初始化调度器
     proc_init();  // 初始化进程模块
+    futex_init(); // 初始化用户态锁的等待队列
+
+    this_cpu()->started = 1;
+    cpu_start_aps(); // 启动其它CPU
 
-    clock_init();  // 初始化定时器
     intr_enable(); // 允许外部中断
 
     ide_init();  // init ide devices
@@ -7,6 +7,8 @@
 #define SEG_UTEXT 3
 #define SEG_UDATA 4
 #define SEG_TSS 5
+#define SEG_CPU 6 // 每个CPU自己的per-CPU数据段，基址是它的struct cpu
+#define N_SEGS 7
 
 /* global descriptor numbers */
 #define GD_KTEXT ((SEG_KTEXT) << 3) // kernel text
@@ -14,6 +16,7 @@
 #define GD_UTEXT ((SEG_UTEXT) << 3) // user text
 #define GD_UDATA ((SEG_UDATA) << 3) // user data
 #define GD_TSS ((SEG_TSS) << 3)     // task segment selector
+#define GD_CPU ((SEG_CPU) << 3)     // per-CPU data
 
 #define DPL_KERNEL (0)
 #define DPL_USER (3)
@@ -28,6 +31,8 @@
  *                                                              kernel/user
  *
  *     4G ------------------> +---------------------------------+
+ *                            |   LAPIC/IOAPIC MMIO (Kern, RW)  | RW/--
+ *     MMIO_BASE -----------> +---------------------------------+ 0xFEC00000
  *                            |                                 |
  *                            |         Empty Memory (*)        |
  *                            |                                 |
@@ -69,6 +74,10 @@
 #define KMEM_SIZE 0x38000000
 #define KERN_TOP (KERN_BASE + KMEM_SIZE)
 #define VPT 0xFAC00000
+#define MMIO_BASE 0xFEC00000 // IOAPIC和local APIC的寄存器，按物理地址原样映射
+
+// AP启动代码被复制到这个物理地址，必须4KB对齐并且在1MB以下
+#define AP_ENTRY_PA 0x7000
 
 // 用户空间
 #define USER_TOP 0xB0000000
@@ -155,6 +155,19 @@ static void boot_map_segment(pde_t *pgdir, uintptr_t la, size_t size, uintptr_t
     }
 }
 
+/* *
+ * mmio_map - map the device registers at physical address @pa for the kernel,
+ * at the same virtual address and uncached. Only for the MMIO area above
+ * MMIO_BASE, and must be called before any process is created, so that the
+ * page table is shared by every page directory copied from g_boot_pgdir.
+ * */
+void *mmio_map(uintptr_t pa, size_t size)
+{
+    assert(pa >= MMIO_BASE && pa + size > pa);
+    boot_map_segment(g_boot_pgdir, pa, size, pa, PTE_W | PTE_PCD | PTE_PWT);
+    return (void *)pa;
+}
+
 // 开启页机制
 static void enable_paging(void)
 {
@@ -168,24 +181,21 @@ static void enable_paging(void)
     lcr0(cr0);
 }
 
-// 全局描述符表
-static struct seg_desc g_gdt[] = {
+// 全局描述符表的模板，每个CPU复制一份，再填上自己的TSS和per-CPU数据段
+static const struct seg_desc g_gdt[N_SEGS] = {
     SEG_NULL,
     [SEG_KTEXT] = SEG_DESC(STA_X | STA_R, 0x0, 0xFFFFFFFF, DPL_KERNEL),
     [SEG_KDATA] = SEG_DESC(STA_W, 0x0, 0xFFFFFFFF, DPL_KERNEL),
     [SEG_UTEXT] = SEG_DESC(STA_X | STA_R, 0x0, 0xFFFFFFFF, DPL_USER),
     [SEG_UDATA] = SEG_DESC(STA_W, 0x0, 0xFFFFFFFF, DPL_USER),
-    [SEG_TSS] = SEG_NULL};
-static struct dt_desc g_gdt_desc = {sizeof(g_gdt) - 1, (uint32_t)g_gdt};
+    [SEG_TSS] = SEG_NULL,
+    [SEG_CPU] = SEG_NULL};
 
-// 任务状态段
-static struct task_state g_ts;
-
-// 加载全局描述符表
+// 加载全局描述符表，内核态的%gs指向per-CPU数据段
 static inline void lgdt(struct dt_desc *dt)
 {
     __asm__ __volatile__("lgdt (%0)" ::"r"(dt));
-    __asm__ __volatile__("movw %%ax, %%gs" ::"a"(USER_DS));
+    __asm__ __volatile__("movw %%ax, %%gs" ::"a"(GD_CPU));
     __asm__ __volatile__("movw %%ax, %%fs" ::"a"(USER_DS));
     __asm__ __volatile__("movw %%ax, %%es" ::"a"(KERNEL_DS));
     __asm__ __volatile__("movw %%ax, %%ds" ::"a"(KERNEL_DS));
@@ -194,29 +204,47 @@ static inline void lgdt(struct dt_desc *dt)
     __asm__ __volatile__("ljmp %0, $1f\n 1:\n" ::"i"(KERNEL_CS));
 }
 
-// 更新tss的esp0，指定ring0的栈地址
+// 更新当前CPU的tss的esp0，指定ring0的栈地址
 void load_esp0(uintptr_t esp0)
 {
-    g_ts.ts_esp0 = esp0;
+    this_cpu()->ts.ts_esp0 = esp0;
 }
 
-// 初始化全局描述符表
-static void gdt_init(void)
+/* *
+ * gdt_init - load the gdt and tss of @cpu on the current CPU. @esp0 is the
+ * kernel stack to use until the first process switch.
+ * */
+void gdt_init(struct cpu *cpu, uintptr_t esp0)
 {
+    cpu->self = cpu;
+    cpu->cr3 = rcr3();
+
     // 当中断需要提权时，会切换堆栈，比如提升到ring0，那么就会切换到TSS中的esp0和ss0
-    // 实际上每个用户进程会单独分配一个内核栈，这里初始化就先用内核本身的栈了
-    load_esp0(kern_stack_top);
-    g_ts.ts_ss0 = KERNEL_DS;
+    // 实际上每个用户进程会单独分配一个内核栈，这里初始化就先用idle进程的栈了
+    cpu->ts.ts_esp0 = esp0;
+    cpu->ts.ts_ss0 = KERNEL_DS;
 
-    // initialize the TSS field of the gdt
-    g_gdt[SEG_TSS] = SEG_1M_DESC(STS_T32A, (uint32_t)&g_ts, sizeof(g_ts), DPL_KERNEL);
-    g_gdt[SEG_TSS].sd_s = 0;
+    memcpy(cpu->gdt, g_gdt, sizeof(g_gdt));
+    cpu->gdt[SEG_TSS] = SEG_1M_DESC(STS_T32A, (uint32_t)&(cpu->ts), sizeof(cpu->ts), DPL_KERNEL);
+    cpu->gdt[SEG_TSS].sd_s = 0;
+    cpu->gdt[SEG_CPU] = SEG_DESC(STA_W, (uint32_t)cpu, 0xFFFFFFFF, DPL_KERNEL);
 
     // 重新加载全局描述符表
-    lgdt(&g_gdt_desc);
+    struct dt_desc gdt_desc = {sizeof(cpu->gdt) - 1, (uint32_t)cpu->gdt};
+    lgdt(&gdt_desc);
 
     // load the TSS
     ltr(GD_TSS);
+
+    // sysenter进内核时的%esp指向tss的esp0字段，入口再从那里取出当前进程的内核栈
+    // sysexit回用户态的段选择子是SYSENTER_CS+16和+24，正好是USER_CS和USER_DS
+    if (cpu_has_sysenter())
+    {
+        extern char __sysenter_entry[];
+        wrmsr(MSR_SYSENTER_CS, GD_KTEXT);
+        wrmsr(MSR_SYSENTER_ESP, (uintptr_t)&(cpu->ts.ts_esp0));
+        wrmsr(MSR_SYSENTER_EIP, (uintptr_t)__sysenter_entry);
+    }
 }
 
 // 初始化物理内存管理
@@ -248,7 +276,7 @@ void pmm_init(void)
     enable_paging();
 
     // 最后再加载gdt，变为平坦模式，也就是逻辑地址等于线性地址，后续就靠页机制做重定位了
-    gdt_init();
+    gdt_init(&g_cpus[0], (uintptr_t)kern_stack_top);
 
     // 这时可以取消临时的映射了
     g_boot_pgdir[0] = 0;
@@ -297,12 +325,17 @@ size_t n_free_pages(void)
 
 // invalidate a TLB entry, but only if the page tables being
 // edited are the ones currently in use by the processor.
+// 其它CPU上正在用这个页目录表的话也要让它们刷新
 void tlb_invalidate(pde_t *pgdir, uintptr_t la)
 {
     if (rcr3() == PADDR(pgdir))
     {
         invlpg((void *)la);
     }
+    if (g_ncpu > 1)
+    {
+        tlb_shootdown(PADDR(pgdir));
+    }
 }
 
 // page_remove_pte - free an Page sturct which is related linear address la
@@ -321,6 +354,12 @@ static inline void page_remove_pte(pde_t *pgdir, uintptr_t la, pte_t *ptep)
         *ptep = 0;
         tlb_invalidate(pgdir, la);
     }
+    else if (*ptep != 0)
+    {
+        // 不存在但非0的页表项是swap entry
+        swap_remove_entry(*ptep);
+        *ptep = 0;
+    }
 }
 
 // page_remove - free an Page which is related linear address la and has an validated pte
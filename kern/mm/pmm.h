@@ -6,6 +6,7 @@
 #include "kern/mm/mmu.h"
 #include "kern/debug/assert.h"
 #include "kern/mm/vmm.h"
+#include "kern/process/cpu.h"
 
 // 物理内存管理框架，主要用来管理物理页
 struct pmm_manager
@@ -74,6 +75,8 @@ pde2page(pde_t pde)
 struct page_desc *alloc_pages(size_t n);           // 分配连续的n个页
 void free_pages(struct page_desc *base, size_t n); // 释放n个连续的页
 size_t n_free_pages(void);                         // 获取内存管理器中总的空闲页数量
+void *mmio_map(uintptr_t pa, size_t size);         // 映射设备寄存器
+void gdt_init(struct cpu *cpu, uintptr_t esp0);    // 加载CPU的全局描述符表和任务状态段
 
 #define alloc_page() alloc_pages(1)
 #define free_page(page) free_pages(page, 1)
@@ -83,6 +86,8 @@ int copy_range(pde_t *to, pde_t *from, uintptr_t start, uintptr_t end, bool shar
 struct page_desc *pgdir_alloc_page(struct mm_struct *mm, pde_t *pgdir, uintptr_t la, uint32_t perm);
 void unmap_range(pde_t *pgdir, uintptr_t start, uintptr_t end);
 void exit_range(pde_t *pgdir, uintptr_t start, uintptr_t end);
+int page_insert(pde_t *pgdir, struct page_desc *page, uintptr_t la, uint32_t perm);
+void tlb_invalidate(pde_t *pgdir, uintptr_t la);
 
 // 根据线性地址la获取对应的页表项，如果create为true那么页表缺失的话自动创建
 pte_t *get_pte(pde_t *pgdir, uintptr_t la, bool create);
@@ -4,9 +4,12 @@
 #include "kern/debug/assert.h"
 #include "kern/driver/stdio.h"
 #include "kern/mm/swap_fifo.h"
+#include "kern/mm/zswap.h"
 #include "libs/string.h"
 #include "kern/mm/pmm.h"
 #include "kern/mm/mem_layout.h"
+#include "kern/driver/clock.h"
+#include "kern/sync/sync.h"
 #include "libs/string.h"
 
 // the valid vaddr for check is between 0~CHECK_VALID_VADDR-1
@@ -23,6 +26,16 @@ size_t max_swap_offset;
 
 volatile int swap_init_ok = 0;
 
+// 交换子系统的全局统计
+static struct
+{
+     size_t slots_used;     // 交换磁盘上正在使用的槽位数
+     uint64_t read_bytes;   // 从交换磁盘读的字节数
+     uint64_t write_bytes;  // 写到交换磁盘的字节数
+     size_t n_swapin;       // 换入的总次数
+     uint64_t swapin_ticks; // 换入花费的总ticks
+} swap_stats;
+
 unsigned int swap_page[CHECK_VALID_VIR_PAGE_NUM];
 
 unsigned int swap_in_seq_no[MAX_SEQ_NO], swap_out_seq_no[MAX_SEQ_NO];
@@ -33,10 +46,7 @@ int swap_init(void)
 {
      swapfs_init();
 
-     if (!(1024 <= max_swap_offset && max_swap_offset < MAX_SWAP_OFFSET_LIMIT))
-     {
-          panic("bad max_swap_offset %08x.\n", max_swap_offset);
-     }
+     zswap_init();
 
      sm = &swap_manager_fifo;
      int r = sm->init();
@@ -71,8 +81,6 @@ int swap_set_unswappable(struct mm_struct *mm, uintptr_t addr)
      return sm->set_unswappable(mm, addr);
 }
 
-volatile unsigned int swap_out_num = 0;
-
 int swap_out(struct mm_struct *mm, int n, int in_tick)
 {
      int i;
@@ -96,18 +104,28 @@ int swap_out(struct mm_struct *mm, int n, int in_tick)
           pte_t *ptep = get_pte(mm->pgdir, v, 0);
           assert((*ptep & PTE_P) != 0);
 
-          if (swapfs_write((page->pra_vaddr / PG_SIZE + 1) << 8, page) != 0)
-          {
-               cprintf("SWAP: failed to save\n");
-               sm->map_swappable(mm, v, page, 0);
-               continue;
-          }
-          else
+          // 先尝试压缩放到内存池里，放不下再写到交换磁盘上
+          swap_entry_t entry;
+          if (zswap_store(page, &entry) != 0)
           {
-               cprintf("swap_out: i %d, store page in vaddr 0x%x to disk swap entry %d\n", i, v, page->pra_vaddr / PG_SIZE + 1);
-               *ptep = (page->pra_vaddr / PG_SIZE + 1) << 8;
-               free_page(page);
+               if (swapfs_alloc(&entry) != 0)
+               {
+                    sm->map_swappable(mm, v, page, 0);
+                    break;
+               }
+               if (swapfs_write(entry, page) != 0)
+               {
+                    cprintf("SWAP: failed to save\n");
+                    swapfs_free(entry);
+                    sm->map_swappable(mm, v, page, 0);
+                    continue;
+               }
+               swap_stats.slots_used++;
+               swap_stats.write_bytes += PG_SIZE;
           }
+          *ptep = entry;
+          free_page(page);
+          mm->n_swapout++;
 
           tlb_invalidate(mm->pgdir, v);
      }
@@ -123,15 +141,181 @@ int swap_in(struct mm_struct *mm, uintptr_t addr, struct page_desc **ptr_result)
      // cprintf("SWAP: load ptep %x swap entry %d to vaddr 0x%08x, page %x, No %d\n", ptep, (*ptep)>>8, addr, result, (result-pages));
 
      int r;
-     if ((r = swapfs_read((*ptep), result)) != 0)
+     size_t start = g_ticks;
+     swap_entry_t entry = *ptep;
+     if (swap_entry_in_zswap(entry))
      {
-          assert(r != 0);
+          // 页已经回到内存，池子里的副本就没用了
+          if ((r = zswap_load(entry, result)) != 0)
+          {
+               free_page(result);
+               return r;
+          }
+          zswap_free(entry);
      }
-     cprintf("swap_in: load disk swap entry %d with swap_page in vadr 0x%x\n", (*ptep) >> 8, addr);
+     else
+     {
+          if ((r = swapfs_read(entry, result)) != 0)
+          {
+               free_page(result);
+               return r;
+          }
+          swapfs_free(entry);
+          swap_stats.slots_used--;
+          swap_stats.read_bytes += PG_SIZE;
+     }
+     swap_stats.n_swapin++;
+     swap_stats.swapin_ticks += g_ticks - start;
+     mm->n_swapin++;
+
      *ptr_result = result;
      return 0;
 }
 
+// 页表项被清除时释放它所指向的交换空间
+void swap_remove_entry(swap_entry_t entry)
+{
+     if (swap_entry_in_zswap(entry))
+     {
+          zswap_free(entry);
+     }
+     else
+     {
+          swapfs_free(entry);
+          swap_stats.slots_used--;
+     }
+}
+
+// 获取交换子系统的统计信息，mm为NULL时进程相关的统计都为0
+void swap_stat(struct mm_struct *mm, struct swapstat *stat)
+{
+     memset(stat, 0, sizeof(struct swapstat));
+     if (mm != NULL)
+     {
+          stat->ss_minflt = mm->n_minflt;
+          stat->ss_majflt = mm->n_majflt;
+          stat->ss_swapin = mm->n_swapin;
+          stat->ss_swapout = mm->n_swapout;
+     }
+
+     bool intr_flag;
+     local_intr_save(intr_flag);
+     {
+          stat->ss_slots_used = swap_stats.slots_used;
+          stat->ss_slots_total = swapfs_n_slots();
+          zswap_stat(&(stat->ss_zswap_pages), &(stat->ss_zswap_bytes));
+          stat->ss_read_bytes = swap_stats.read_bytes;
+          stat->ss_write_bytes = swap_stats.write_bytes;
+          stat->ss_swapin_total = swap_stats.n_swapin;
+          if (swap_stats.n_swapin != 0)
+          {
+               uint64_t avg = swap_stats.swapin_ticks;
+               do_div(avg, swap_stats.n_swapin);
+               stat->ss_swapin_ticks = avg;
+          }
+     }
+     local_intr_restore(intr_flag);
+}
+
+#define SWAP_SELFTEST_BASE UTEXT // 自检用的虚拟地址，只在自检自己的页表里
+#define SWAP_SELFTEST_NPAGES 8   // 一半能压缩，一半不能
+
+// 自检的第i页的内容：前一半页是重复的字节，后一半是压缩不了的伪随机数
+static void swap_selftest_fill(uint32_t *data, int i, bool check)
+{
+     uint32_t x = i * 2654435761u + 1;
+     for (int j = 0; j < PG_SIZE / sizeof(uint32_t); j++)
+     {
+          uint32_t v = 0x01010101 * i;
+          if (i >= SWAP_SELFTEST_NPAGES / 2)
+          {
+               x = x * 1103515245 + 12345;
+               v = x ^ (x >> 16);
+          }
+          if (check)
+          {
+               assert(data[j] == v);
+          }
+          else
+          {
+               data[j] = v;
+          }
+     }
+}
+
+/* *
+ * swap_selftest - swap the pages of a scratch mm out and back in, checking
+ * their contents. The compressible pages should end up in zswap and the
+ * others on the swap disk or file. Nothing else calls swap_out, so this is
+ * what exercises the swap path. Called at boot once the swap file is on,
+ * before any user process exists.
+ * */
+void swap_selftest(void)
+{
+     struct mm_struct *mm = mm_create();
+     struct page_desc *pgdir_page = alloc_page();
+     assert(mm != NULL && pgdir_page != NULL);
+     pde_t *pgdir = mm->pgdir = page2kva(pgdir_page);
+     memcpy(pgdir, g_boot_pgdir, PG_SIZE);
+
+     size_t slots_used = swap_stats.slots_used, zswap_pages, zswap_bytes;
+     zswap_stat(&zswap_pages, &zswap_bytes);
+
+     uintptr_t start = SWAP_SELFTEST_BASE, end = start + SWAP_SELFTEST_NPAGES * PG_SIZE;
+     for (int i = 0; i < SWAP_SELFTEST_NPAGES; i++)
+     {
+          // 先分配的先被换出，能压缩的页排在前面，没有交换磁盘时也能先放进zswap
+          struct page_desc *page = pgdir_alloc_page(mm, pgdir, start + i * PG_SIZE, PTE_USER);
+          assert(page != NULL);
+          swap_selftest_fill(page2kva(page), i, 0);
+     }
+
+     int n_out = swap_out(mm, SWAP_SELFTEST_NPAGES, 0), n_zswap = 0, n_disk = 0;
+     for (int i = 0; i < SWAP_SELFTEST_NPAGES; i++)
+     {
+          uintptr_t la = start + i * PG_SIZE;
+          pte_t *ptep = get_pte(pgdir, la, 0);
+          if (*ptep & PTE_P)
+          {
+               continue;
+          }
+          if (swap_entry_in_zswap(*ptep))
+          {
+               n_zswap++;
+          }
+          else
+          {
+               n_disk++;
+          }
+          struct page_desc *page;
+          assert(swap_in(mm, la, &page) == 0);
+          page_insert(pgdir, page, la, PTE_USER);
+          swap_map_swappable(mm, la, page, 1);
+          page->pra_vaddr = la;
+          swap_selftest_fill(page2kva(page), i, 1);
+     }
+     assert(n_out == n_zswap + n_disk);
+     assert(ZSWAP_ARENA_PAGES == 0 || n_zswap == SWAP_SELFTEST_NPAGES / 2);
+     assert(swapfs_n_slots() == 0 || n_disk == SWAP_SELFTEST_NPAGES - n_zswap);
+
+     // 页都回到了内存，从换出队列里摘下来再释放
+     for (int i = 0; i < SWAP_SELFTEST_NPAGES; i++)
+     {
+          pte_t *ptep = get_pte(pgdir, start + i * PG_SIZE, 0);
+          list_del(&(pte2page(*ptep)->pra_page_link));
+     }
+     unmap_range(pgdir, start, end);
+     exit_range(pgdir, start, end);
+     free_page(pgdir_page);
+     mm->pgdir = NULL;
+     mm_destroy(mm);
+
+     size_t zswap_pages_after;
+     zswap_stat(&zswap_pages_after, &zswap_bytes);
+     assert(swap_stats.slots_used == slots_used && zswap_pages_after == zswap_pages);
+     cprintf("swap_selftest() succeeded: %d pages via zswap, %d via the swap disk or file.\n", n_zswap, n_disk);
+}
+
 static inline void
 check_content_set(void)
 {
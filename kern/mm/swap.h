@@ -5,6 +5,7 @@
 #include "kern/mm/mem_layout.h"
 #include "kern/mm/pmm.h"
 #include "kern/mm/vmm.h"
+#include "libs/swapstat.h"
 
 /* *
  * swap_entry_t
@@ -16,7 +17,7 @@
 
 #define MAX_SWAP_OFFSET_LIMIT (1 << 24)
 
-// 最大的交换扇区
+// 交换空间里offset的上界（不含），由swapfs在添加交换区时更新
 extern size_t max_swap_offset;
 
 typedef pte_t swap_entry_t; // the pte can also be a swap entry
@@ -62,6 +63,9 @@ int swap_map_swappable(struct mm_struct *mm, uintptr_t addr, struct page_desc *p
 int swap_set_unswappable(struct mm_struct *mm, uintptr_t addr);
 int swap_out(struct mm_struct *mm, int n, int in_tick);
 int swap_in(struct mm_struct *mm, uintptr_t addr, struct page_desc **ptr_result);
+void swap_remove_entry(swap_entry_t entry);
+void swap_stat(struct mm_struct *mm, struct swapstat *stat);
+void swap_selftest(void);
 
 //#define MEMBER_OFFSET(m,t) ((int)(&((t *)0)->m))
 //#define FROM_MEMBER(m,t,a) ((t *)((char *)(a) - MEMBER_OFFSET(m,t)))
@@ -6,6 +6,8 @@
 #include "libs/string.h"
 #include "kern/driver/stdio.h"
 #include "kern/mm/swap.h"
+#include "kern/mm/zswap.h"
+#include "kern/process/proc.h"
 #include "kern/debug/assert.h"
 #include "libs/x86.h"
 #include "libs/error.h"
@@ -38,6 +40,9 @@ struct mm_struct *mm_create(void)
 
         mm->mm_count = 0;
         sem_init(&(mm->mm_sem), 1);
+
+        mm->n_minflt = mm->n_majflt = 0;
+        mm->n_swapin = mm->n_swapout = 0;
     }
     return mm;
 }
@@ -229,6 +234,22 @@ struct mm_struct *check_mm_struct;
 // page fault number
 volatile unsigned int pgfault_num = 0;
 
+// 缺页次数同时记到引起缺页的进程上，启动时的自检没有当前进程
+static void pgfault_count(bool major)
+{
+    if (g_cur_proc != NULL)
+    {
+        if (major)
+        {
+            g_cur_proc->majflt++;
+        }
+        else
+        {
+            g_cur_proc->minflt++;
+        }
+    }
+}
+
 // 缺页异常发生后
 // cr2寄存器会存储引起缺页异常的线性地址
 // 中断硬件压入的错误码
@@ -299,6 +320,8 @@ int do_pgfault(struct mm_struct *mm, uint32_t error_code, uintptr_t addr)
             cprintf("pgdir_alloc_page in do_pgfault failed\n");
             goto failed;
         }
+        mm->n_minflt++;
+        pgfault_count(0);
     }
     else
     { // if this pte is a swap entry, then load data from disk to a page with phy addr
@@ -306,6 +329,17 @@ int do_pgfault(struct mm_struct *mm, uint32_t error_code, uintptr_t addr)
         if (swap_init_ok)
         {
             struct page_desc *page = NULL;
+            // 从压缩交换池换入不需要磁盘I/O，算作minor fault
+            if (swap_entry_in_zswap(*ptep))
+            {
+                mm->n_minflt++;
+                pgfault_count(0);
+            }
+            else
+            {
+                mm->n_majflt++;
+                pgfault_count(1);
+            }
             if ((ret = swap_in(mm, addr, &page)) != 0)
             {
                 cprintf("swap_in in do_pgfault failed\n");
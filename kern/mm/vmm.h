@@ -38,6 +38,10 @@ struct mm_struct
     int mm_count;                  // the number ofprocess which shared the mm
     semaphore_t mm_sem;            // mutex for using dup_mmap fun to duplicat the mm
     int locked_by;                 // the lock owner process's pid
+    size_t n_minflt;               // 不需要读交换磁盘就能处理的缺页次数
+    size_t n_majflt;               // 需要读交换磁盘的缺页次数
+    size_t n_swapin;               // 换入的页数
+    size_t n_swapout;              // 换出的页数
 };
 
 static inline void lock_mm(struct mm_struct *mm)
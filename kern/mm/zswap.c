@@ -0,0 +1,191 @@
+#include "kern/mm/zswap.h"
+#include "kern/mm/pmm.h"
+#include "kern/sync/sync.h"
+#include "kern/debug/assert.h"
+#include "kern/driver/stdio.h"
+#include "libs/atomic.h"
+#include "libs/string.h"
+#include "libs/error.h"
+#include "libs/lz.h"
+
+#define ZSWAP_N_CHUNKS (ZSWAP_ARENA_PAGES * PG_SIZE / ZSWAP_CHUNK_SIZE)
+
+#define zswap_entry_slot(entry) (((entry) >> 8) - 1)
+
+// 池子里一个压缩页的位置
+struct zswap_slot
+{
+    uint16_t chunk; // 起始块号
+    uint16_t len;   // 压缩后的字节数，0表示槽位空闲
+};
+
+static char *zswap_arena;                              // 存放压缩页的内存
+static uint32_t zswap_chunk_map[ZSWAP_N_CHUNKS / 32];  // 块的占用位图
+static struct zswap_slot zswap_slots[ZSWAP_MAX_SLOTS]; // 槽位表
+static uint16_t zswap_free_slots[ZSWAP_MAX_SLOTS];     // 空闲槽位栈
+static int zswap_n_free_slots;                         // 空闲槽位数量
+static uint8_t zswap_buf[ZSWAP_MAX_LEN];               // 压缩用的临时缓冲区
+static size_t zswap_n_bytes;                           // 池子里压缩数据的总字节数
+
+// 初始化压缩交换池，预留出池子的内存
+void zswap_init(void)
+{
+    static_assert(ZSWAP_N_CHUNKS % 32 == 0);
+    static_assert(ZSWAP_N_CHUNKS <= 0x10000);
+    static_assert(ZSWAP_MAX_SLOTS < MAX_SWAP_OFFSET_LIMIT);
+
+    if (ZSWAP_ARENA_PAGES == 0)
+    {
+        return;
+    }
+
+    struct page_desc *page = alloc_pages(ZSWAP_ARENA_PAGES);
+    if (page == NULL)
+    {
+        cprintf("ZSWAP: no memory for %d pages arena, disabled\n", ZSWAP_ARENA_PAGES);
+        return;
+    }
+    zswap_arena = page2kva(page);
+
+    memset(zswap_chunk_map, 0, sizeof(zswap_chunk_map));
+    for (int i = 0; i < ZSWAP_MAX_SLOTS; i++)
+    {
+        zswap_slots[i].len = 0;
+        zswap_free_slots[i] = ZSWAP_MAX_SLOTS - 1 - i;
+    }
+    zswap_n_free_slots = ZSWAP_MAX_SLOTS;
+
+    cprintf("ZSWAP: arena = %d KB, max slots = %d\n", ZSWAP_ARENA_PAGES * PG_SIZE / 1024, ZSWAP_MAX_SLOTS);
+}
+
+// 首次适配分配n个连续的块，返回起始块号，失败返回-1
+static int zswap_chunk_alloc(size_t n)
+{
+    size_t start = 0, run = 0;
+    for (size_t i = 0; i < ZSWAP_N_CHUNKS; i++)
+    {
+        // 整个字都被占用了就直接跳过
+        if (i % 32 == 0 && zswap_chunk_map[i / 32] == 0xFFFFFFFF)
+        {
+            run = 0;
+            i += 31;
+            continue;
+        }
+        if (test_bit(i, zswap_chunk_map))
+        {
+            run = 0;
+            continue;
+        }
+        if (run++ == 0)
+        {
+            start = i;
+        }
+        if (run == n)
+        {
+            for (i = start; i < start + n; i++)
+            {
+                set_bit(i, zswap_chunk_map);
+            }
+            return start;
+        }
+    }
+    return -1;
+}
+
+static void zswap_chunk_free(size_t start, size_t n)
+{
+    for (size_t i = start; i < start + n; i++)
+    {
+        assert(test_bit(i, zswap_chunk_map));
+        clear_bit(i, zswap_chunk_map);
+    }
+}
+
+/* *
+ * zswap_store - compress @page into the pool
+ *
+ * On success the swap entry of the stored copy is written to @entry_store.
+ * Returns -E_NO_MEM if the pool is disabled or full, or the page doesn't
+ * compress below ZSWAP_MAX_LEN; the caller should write it to disk then.
+ * */
+int zswap_store(struct page_desc *page, swap_entry_t *entry_store)
+{
+    if (zswap_arena == NULL)
+    {
+        return -E_NO_MEM;
+    }
+
+    int ret = -E_NO_MEM;
+    bool intr_flag;
+    local_intr_save(intr_flag);
+    {
+        size_t len = lz_compress(page2kva(page), PG_SIZE, zswap_buf, ZSWAP_MAX_LEN);
+        if (len != 0 && zswap_n_free_slots != 0)
+        {
+            int chunk = zswap_chunk_alloc(ROUNDUP_DIV(len, ZSWAP_CHUNK_SIZE));
+            if (chunk >= 0)
+            {
+                int slot = zswap_free_slots[--zswap_n_free_slots];
+                zswap_slots[slot].chunk = chunk;
+                zswap_slots[slot].len = len;
+                memcpy(zswap_arena + chunk * ZSWAP_CHUNK_SIZE, zswap_buf, len);
+                zswap_n_bytes += len;
+                *entry_store = ((slot + 1) << 8) | ZSWAP_ENTRY;
+                ret = 0;
+            }
+        }
+    }
+    local_intr_restore(intr_flag);
+    return ret;
+}
+
+// 从池子里解压entry对应的页到page中，池子里的副本仍然保留
+int zswap_load(swap_entry_t entry, struct page_desc *page)
+{
+    size_t slot = zswap_entry_slot(entry);
+    if (!(swap_entry_in_zswap(entry) && slot < ZSWAP_MAX_SLOTS && zswap_slots[slot].len != 0))
+    {
+        panic("invalid zswap entry %08x.\n", entry);
+    }
+
+    int ret = 0;
+    bool intr_flag;
+    local_intr_save(intr_flag);
+    {
+        struct zswap_slot *s = zswap_slots + slot;
+        if (lz_decompress(zswap_arena + s->chunk * ZSWAP_CHUNK_SIZE, s->len, page2kva(page), PG_SIZE) != PG_SIZE)
+        {
+            ret = -E_SWAP_FAULT;
+        }
+    }
+    local_intr_restore(intr_flag);
+    return ret;
+}
+
+// 释放entry在池子里占用的空间
+void zswap_free(swap_entry_t entry)
+{
+    size_t slot = zswap_entry_slot(entry);
+    if (!(swap_entry_in_zswap(entry) && slot < ZSWAP_MAX_SLOTS && zswap_slots[slot].len != 0))
+    {
+        panic("invalid zswap entry %08x.\n", entry);
+    }
+
+    bool intr_flag;
+    local_intr_save(intr_flag);
+    {
+        struct zswap_slot *s = zswap_slots + slot;
+        zswap_chunk_free(s->chunk, ROUNDUP_DIV(s->len, ZSWAP_CHUNK_SIZE));
+        zswap_n_bytes -= s->len;
+        s->len = 0;
+        zswap_free_slots[zswap_n_free_slots++] = slot;
+    }
+    local_intr_restore(intr_flag);
+}
+
+// 获取池子里的页数和压缩后的总字节数
+void zswap_stat(size_t *n_pages_store, size_t *n_bytes_store)
+{
+    *n_pages_store = (zswap_arena != NULL) ? ZSWAP_MAX_SLOTS - zswap_n_free_slots : 0;
+    *n_bytes_store = zswap_n_bytes;
+}
@@ -0,0 +1,34 @@
+#ifndef __KERN_MM_ZSWAP_H__
+#define __KERN_MM_ZSWAP_H__
+
+#include "libs/defs.h"
+#include "kern/mm/swap.h"
+
+/* *
+ * 压缩交换池，位于swap_out和swapfs_write之间
+ *
+ * 换出的页先压缩后放到一块固定大小的内核内存里，池子满了或者页压缩不下来
+ * 才写到交换磁盘上。放在池子里的页对应的swap_entry_t会带上ZSWAP_ENTRY标志，
+ * offset字段为池子里的槽位号：
+ * --------------------------------------------------
+ * |      slot + 1     |   reserved   | 1 |   0    |
+ * --------------------------------------------------
+ *        24 bits          6 bits      1 bit  1 bit
+ * */
+
+#define ZSWAP_ARENA_PAGES 256                    // 池子的页数，设为0关闭压缩交换池
+#define ZSWAP_CHUNK_SIZE 64                      // 池内分配的粒度
+#define ZSWAP_MAX_SLOTS 4096                     // 池子最多能存的页数
+#define ZSWAP_MAX_LEN (PG_SIZE - PG_SIZE / 4)    // 压缩后超过这个大小就不值得放在内存里了
+
+#define ZSWAP_ENTRY 0x2
+
+#define swap_entry_in_zswap(entry) (((entry)&ZSWAP_ENTRY) != 0)
+
+void zswap_init(void);
+int zswap_store(struct page_desc *page, swap_entry_t *entry_store);
+int zswap_load(swap_entry_t entry, struct page_desc *page);
+void zswap_free(swap_entry_t entry);
+void zswap_stat(size_t *n_pages_store, size_t *n_bytes_store);
+
+#endif /* !__KERN_MM_ZSWAP_H__ */
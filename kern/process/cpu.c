@@ -0,0 +1,186 @@
+#include "kern/process/cpu.h"
+#include "kern/process/proc.h"
+#include "kern/sync/sync.h"
+#include "kern/mm/pmm.h"
+#include "kern/trap/trap.h"
+#include "kern/driver/lapic.h"
+#include "kern/driver/clock.h"
+#include "kern/driver/stdio.h"
+#include "kern/debug/assert.h"
+#include "libs/x86.h"
+#include "libs/string.h"
+
+/* *
+ * 多处理器
+ *
+ * 内核目前用一把大内核锁在CPU之间互斥：CPU在内核态时总是持有它，返回用户态
+ * 或者idle进程停机时才释放。这样原来单CPU时靠local_intr_save和内核不可抢占
+ * 保护的数据结构都不用改，用户态的进程可以在多个CPU上并行运行。
+ * */
+
+struct cpu g_cpus[NCPU];
+int g_ncpu = 1;
+
+static spinlock_t g_kernel_lock = {0, NULL, "kernel"};
+
+void kernel_lock(void)
+{
+    struct cpu *cpu = this_cpu();
+    while (!spin_trylock(&g_kernel_lock))
+    {
+        // 持有锁的CPU可能在等我们刷新TLB，等锁时关着中断，只能在这里处理
+        if (cpu->tlb_flush)
+        {
+            tlb_flush_local();
+        }
+        pause();
+    }
+}
+
+void kernel_unlock(void)
+{
+    spin_unlock(&g_kernel_lock);
+}
+
+// 当前CPU是否持有大内核锁
+bool kernel_lock_held(void)
+{
+    return spin_holding(&g_kernel_lock);
+}
+
+// 刷新当前CPU的TLB，响应其它CPU的shootdown
+void tlb_flush_local(void)
+{
+    lcr3(rcr3());
+    this_cpu()->tlb_flush = 0;
+}
+
+/* *
+ * tlb_shootdown - flush the TLB of the other CPUs which are running on the
+ * page directory @cr3, and wait until they are done. Called with the kernel
+ * lock held, after the page table has been changed.
+ * */
+void tlb_shootdown(uintptr_t cr3)
+{
+    struct cpu *self = this_cpu();
+    for (int i = 0; i < g_ncpu; i++)
+    {
+        struct cpu *cpu = g_cpus + i;
+        if (cpu != self && cpu->started && cpu->cr3 == cr3)
+        {
+            cpu->tlb_flush = 1;
+            lapic_send_ipi(cpu->apic_id, T_IPI_TLB);
+        }
+    }
+    for (int i = 0; i < g_ncpu; i++)
+    {
+        while (g_cpus[i].tlb_flush)
+        {
+            pause();
+        }
+    }
+}
+
+// 已经启动的CPU的掩码
+uint32_t cpu_online_mask(void)
+{
+    static_assert(NCPU <= 32);
+    uint32_t mask = 0;
+    for (int i = 0; i < g_ncpu; i++)
+    {
+        if (g_cpus[i].started)
+        {
+            mask |= cpu_mask(g_cpus + i);
+        }
+    }
+    return mask;
+}
+
+// 让cpu尽快重新调度，比如往它空着的运行队列里放了进程
+void cpu_kick(struct cpu *cpu)
+{
+    if (cpu != this_cpu())
+    {
+        lapic_send_ipi(cpu->apic_id, T_IPI_RESCHED);
+    }
+}
+
+// AP进入内核后的C入口，在AP自己的idle进程的内核栈上运行
+static void ap_main(void)
+{
+    struct cpu *cpu = NULL;
+    int apic_id = lapic_id();
+    for (int i = 1; i < g_ncpu && cpu == NULL; i++)
+    {
+        if (g_cpus[i].apic_id == apic_id)
+        {
+            cpu = g_cpus + i;
+        }
+    }
+    if (cpu == NULL)
+    {
+        // 找不到自己，没法用cprintf，直接停下
+        while (1)
+        {
+            __asm__ __volatile__("cli; hlt");
+        }
+    }
+
+    gdt_init(cpu, cpu->idle_proc->kstack + KSTACK_SIZE);
+    idt_load();
+    lapic_init();
+
+    // BSP在持有大内核锁的情况下等started，所以要先设置started再去拿锁
+    cpu->started = 1;
+    kernel_lock();
+    cprintf("cpu%d: apic id %d started.\n", cpu->id, cpu->apic_id);
+
+    cpu_idle();
+}
+
+/* *
+ * cpu_start_aps - start all the APs found by mp_init one by one. Each of them
+ * gets its own idle process, on whose kernel stack it enters ap_main().
+ * */
+void cpu_start_aps(void)
+{
+    if (g_ncpu == 1)
+    {
+        return;
+    }
+
+    extern char ap_entry[], ap_entry_end[];
+    memcpy(KADDR(AP_ENTRY_PA), ap_entry, ap_entry_end - ap_entry);
+    uint32_t *params = (uint32_t *)KADDR(AP_ENTRY_PA);
+
+    // AP开启页机制时还在低地址执行，临时映射[0, 4M)
+    g_boot_pgdir[0] = g_boot_pgdir[PDX(KERN_BASE)];
+
+    for (int i = 1; i < g_ncpu; i++)
+    {
+        struct cpu *cpu = g_cpus + i;
+        struct proc_struct *idle;
+        if ((idle = proc_create_idle(cpu)) == NULL)
+        {
+            panic("cannot alloc idle proc for cpu%d.\n", i);
+        }
+
+        params[-1] = idle->kstack + KSTACK_SIZE;
+        params[-2] = (uint32_t)ap_main;
+        params[-3] = g_boot_cr3;
+        lapic_start_ap(cpu->apic_id, AP_ENTRY_PA);
+
+        // 最多等1秒
+        for (int ms = 0; ms < 1000 && !cpu->started; ms++)
+        {
+            clock_udelay(1000);
+        }
+        if (!cpu->started)
+        {
+            cprintf("cpu%d: apic id %d didn't start.\n", i, cpu->apic_id);
+        }
+    }
+
+    g_boot_pgdir[0] = 0;
+    lcr3(rcr3());
+}
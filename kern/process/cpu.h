@@ -0,0 +1,69 @@
+#ifndef __KERN_PROCESS_CPU_H__
+#define __KERN_PROCESS_CPU_H__
+
+#include "libs/defs.h"
+#include "libs/descriptor.h"
+#include "kern/mm/mmu.h"
+#include "kern/mm/mem_layout.h"
+#include "libs/x86.h"
+
+#define NCPU 8 // 最多支持的CPU数量
+
+#define CPU_MASK_ALL 0xFFFFFFFF      // 亲和性掩码，第i位对应第i个CPU
+#define cpu_mask(cpu) (1 << (cpu)->id) // 只有cpu一个CPU的掩码
+
+struct proc_struct;
+struct run_queue;
+
+/* *
+ * 每个CPU的私有数据
+ *
+ * 每个CPU有自己的gdt，其中SEG_CPU段的基址就是它自己的struct cpu，内核态下
+ * %gs总是装着GD_CPU，所以用%gs:0就能取到当前CPU，不需要去读local APIC。
+ * */
+struct cpu
+{
+    struct cpu *self;              // 指向自己，必须是第一个字段
+    int id;                        // CPU编号，0是BSP
+    uint8_t apic_id;               // local APIC ID
+    volatile bool started;         // 是否已经启动，可以调度进程了
+    struct proc_struct *cur_proc;  // 当前运行的进程
+    struct proc_struct *idle_proc; // idle进程
+    struct run_queue *rq;          // 运行队列
+    uintptr_t cr3;                 // 当前的页目录表，TLB shootdown时用
+    volatile bool tlb_flush;       // 其它CPU要求刷新TLB
+    struct task_state ts;          // 任务状态段
+    struct seg_desc gdt[N_SEGS];   // 全局描述符表
+};
+
+extern struct cpu g_cpus[NCPU];
+extern int g_ncpu;
+
+// 获取当前CPU，调用者需要关中断或者持有大内核锁，否则可能被迁移到其它CPU上
+static inline struct cpu *this_cpu(void)
+{
+    struct cpu *cpu;
+    __asm__ __volatile__("movl %%gs:0, %0"
+                         : "=r"(cpu));
+    return cpu;
+}
+
+// 切换当前CPU的页目录表，并记下来给TLB shootdown用
+static inline void cpu_load_cr3(uintptr_t cr3)
+{
+    lcr3(cr3);
+    this_cpu()->cr3 = cr3;
+}
+
+void kernel_lock(void);
+void kernel_unlock(void);
+bool kernel_lock_held(void);
+
+void tlb_shootdown(uintptr_t cr3);
+void tlb_flush_local(void);
+
+uint32_t cpu_online_mask(void);
+void cpu_kick(struct cpu *cpu);
+void cpu_start_aps(void);
+
+#endif /* !__KERN_PROCESS_CPU_H__ */
@@ -9,13 +9,18 @@
 #include "libs/stdlib.h"
 #include "kern/sync/sync.h"
 #include "kern/trap/trap.h"
+#include "kern/driver/intr.h"
 #include "kern/schedule/sched.h"
+#include "kern/schedule/sched_edf.h"
+#include "kern/schedule/sched_cfs.h"
+#include "kern/schedule/sched_trace.h"
 #include "libs/error.h"
 #include "libs/unistd.h"
 #include "libs/elf.h"
 #include "kern/fs/vfs/vfs.h"
 #include "kern/fs/fs.h"
 #include "kern/fs/file.h"
+#include "kern/fs/swap/swapfs.h"
 
 #define HASH_SHIFT 10
 #define HASH_LIST_SIZE (1 << HASH_SHIFT)
@@ -24,15 +29,17 @@
 list_entry_t g_proc_list;                        // 进程列表
 static list_entry_t g_hash_list[HASH_LIST_SIZE]; // 根据pid哈希之后的进程列表
 
-struct proc_struct *g_idle_proc = NULL; // 内核idle进程
 struct proc_struct *g_init_proc = NULL; // 内核init进程
-struct proc_struct *g_cur_proc = NULL;  // 当前运行的进程
 
 static int n_process = 0;
 
 void kernel_thread_entry(void);
 void forkrets(struct trap_frame *tf);
 void switch_to(struct context *from, struct context *to);
+static void spawn_ret(void);
+
+// 只在内核里用的clone标志：子进程不拷贝虚拟空间，从spawn_ret开始运行装入新程序
+#define CLONE_SPAWN 0x00010000
 
 // set_links - set the relation links of process
 static void
@@ -68,10 +75,68 @@ remove_links(struct proc_struct *proc)
     n_process--;
 }
 
+/* *
+ * proc_struct和内核栈的缓存
+ *
+ * 频繁的fork/exit会反复kmalloc/kfree进程控制块、alloc_pages/free_pages
+ * 内核栈。回收的对象先放进有上限的空闲池里，下次创建进程时直接拿来用，
+ * 池满了才真正释放。池按栈的方式使用，拿到的是最近释放的、还在cache里的对象。
+ * 只在关中断的时候访问。
+ * */
+#define PROC_CACHE_MAX 32
+
+static struct proc_struct *proc_cache[PROC_CACHE_MAX];
+static uintptr_t kstack_cache[PROC_CACHE_MAX];
+static struct proc_cache_stat proc_cache_stats;
+
+static struct proc_struct *proc_cache_get(void)
+{
+    struct proc_struct *proc = NULL;
+    bool intr_flag;
+    local_intr_save(intr_flag);
+    if (proc_cache_stats.procs_cached > 0)
+    {
+        proc = proc_cache[--proc_cache_stats.procs_cached];
+        proc_cache_stats.proc_hits++;
+    }
+    else
+    {
+        proc_cache_stats.proc_misses++;
+    }
+    local_intr_restore(intr_flag);
+    return (proc != NULL) ? proc : kmalloc(sizeof(struct proc_struct));
+}
+
+// 释放proc对象，池满了才还给kmalloc
+static void free_proc(struct proc_struct *proc)
+{
+    bool intr_flag;
+    local_intr_save(intr_flag);
+    if (proc_cache_stats.procs_cached < PROC_CACHE_MAX)
+    {
+        proc_cache[proc_cache_stats.procs_cached++] = proc;
+        proc = NULL;
+    }
+    local_intr_restore(intr_flag);
+    if (proc != NULL)
+    {
+        kfree(proc);
+    }
+}
+
+// proc_cache_stat - get the hit counters and sizes of the proc_struct and kernel stack pools
+void proc_cache_stat(struct proc_cache_stat *stat)
+{
+    bool intr_flag;
+    local_intr_save(intr_flag);
+    *stat = proc_cache_stats;
+    local_intr_restore(intr_flag);
+}
+
 // 创建一个proc对象
 static struct proc_struct *alloc_proc(void)
 {
-    struct proc_struct *proc = kmalloc(sizeof(struct proc_struct));
+    struct proc_struct *proc = proc_cache_get();
     if (proc != NULL)
     {
         proc->state = PROC_UNINIT;
@@ -98,8 +163,25 @@ static struct proc_struct *alloc_proc(void)
         proc->time_slice = 0;
         skew_heap_init(&(proc->run_pool));
         proc->stride = 0;
-        proc->priority = 0;
+        proc->priority = 1;
+        proc->mlfq_level = 0;
+        proc->vruntime = 0;
+        proc->nice = 0;
+        proc->dl_runtime = proc->dl_deadline = proc->dl_period = 0;
+        proc->dl_abs_deadline = 0;
+        proc->dl_remaining = 0;
+        proc->dl_throttled = 0;
+        timer_init(&(proc->dl_timer), proc, 0);
+        proc->run_ticks = proc->wait_ticks = proc->wait_start = 0;
+        proc->nvcsw = proc->nivcsw = 0;
+        proc->migrations = 0;
+        proc->cpus_allowed = CPU_MASK_ALL;
         proc->filesp = NULL;
+        list_init(&(proc->thread_group));
+        proc->utime = proc->stime = 0;
+        proc->minflt = proc->majflt = 0;
+        proc->read_bytes = proc->write_bytes = 0;
+        memset(&(proc->child_rusage), 0, sizeof(struct rusage));
     }
     return proc;
 }
@@ -120,46 +202,46 @@ get_proc_name(struct proc_struct *proc)
     return memcpy(name, proc->name, PROC_NAME_LEN);
 }
 
-// get_pid - alloc a unique pid for process
+static uint32_t g_pid_map[MAX_PID / 32]; // 已分配的pid的位图
+static int g_last_pid;                    // 上次分配的pid
+
+/* *
+ * get_pid - alloc a unique pid for process. Pids are handed out in increasing
+ * order from the last one and wrap around at MAX_PID, so a freed pid is not
+ * reused at once. The bitmap is scanned a word at a time with bsf, which
+ * costs at most MAX_PID / 32 word reads even when most pids are in use.
+ * */
 static int get_pid(void)
 {
-    static_assert(MAX_PID > MAX_PROCESS);
-    struct proc_struct *proc;
-    list_entry_t *list = &g_proc_list, *le;
-    static int next_safe = MAX_PID, last_pid = MAX_PID;
-    if (++last_pid >= MAX_PID)
-    {
-        last_pid = 1;
-        goto inside;
-    }
-    if (last_pid >= next_safe)
+    static_assert(MAX_PID > MAX_PROCESS && MAX_PID % 32 == 0);
+    int start = g_last_pid + 1;
+    for (int i = 0; i <= MAX_PID / 32; i++)
     {
-    inside:
-        next_safe = MAX_PID;
-    repeat:
-        le = list;
-        while ((le = list_next(le)) != list)
+        // pid 0是idle进程的，位图里一直占着
+        if (start >= MAX_PID)
         {
-            proc = le2proc(le, list_link);
-            if (proc->pid == last_pid)
-            {
-                if (++last_pid >= next_safe)
-                {
-                    if (last_pid >= MAX_PID)
-                    {
-                        last_pid = 1;
-                    }
-                    next_safe = MAX_PID;
-                    goto repeat;
-                }
-            }
-            else if (proc->pid > last_pid && next_safe > proc->pid)
-            {
-                next_safe = proc->pid;
-            }
+            start = 1;
+        }
+        int word = start / 32;
+        uint32_t free = ~g_pid_map[word] & (0xFFFFFFFF << (start % 32));
+        if (free != 0)
+        {
+            int pid = word * 32 + bsf(free);
+            set_bit(pid, g_pid_map);
+            g_last_pid = pid;
+            return pid;
         }
+        start = (word + 1) * 32;
     }
-    return last_pid;
+    // 进程数不超过MAX_PROCESS，不会走到这里
+    panic("no free pid.\n");
+    return -E_NO_FREE_PROC;
+}
+
+// put_pid - free the pid of a reaped process
+static void put_pid(int pid)
+{
+    clear_bit(pid, g_pid_map);
 }
 
 // 切换运行进程
@@ -168,23 +250,41 @@ void proc_run(struct proc_struct *proc)
     if (proc != g_cur_proc)
     {
         bool intr_flag;
-        struct proc_struct *prev = g_cur_proc, *next = proc;
         local_intr_save(intr_flag);
         {
-            g_cur_proc = proc;
-            load_esp0(next->kstack + KSTACK_SIZE);
-            lcr3(next->cr3);
-            switch_to(&(prev->context), &(next->context));
+            __proc_run(proc);
         }
         local_intr_restore(intr_flag);
     }
 }
 
+// __proc_run - switch from the current process to @next, which must be another one.
+// Called with interrupts disabled, e.g. by schedule()
+void __proc_run(struct proc_struct *next)
+{
+    struct cpu *cpu = this_cpu();
+    struct proc_struct *prev = cpu->cur_proc;
+    sched_trace(SCHED_EV_RUN, next->pid, prev->pid);
+    cpu->cur_proc = next;
+    load_esp0(next->kstack + KSTACK_SIZE);
+    // 内核线程之间切换时页目录表不变，不用重新加载cr3冲掉TLB
+    if (cpu->cr3 != next->cr3)
+    {
+        cpu_load_cr3(next->cr3);
+    }
+    switch_to(&(prev->context), &(next->context));
+}
+
 // forkret -- the first kernel entry point of a new thread/process
 // NOTE: the addr of forkret is setted in copy_thread function
 //       after switch_to, the g_cur_proc proc will execute here.
 static void forkret(void)
 {
+    // 新进程直接返回用户态的话，要像trap返回时一样释放大内核锁
+    if (!trap_in_kernel(g_cur_proc->tf))
+    {
+        kernel_unlock();
+    }
     forkrets(g_cur_proc->tf);
 }
 
@@ -229,15 +329,28 @@ int kernel_thread(int (*fn)(void *), void *arg, uint32_t clone_flags)
     memset(&tf, 0, sizeof(struct trap_frame));
     tf.tf_cs = KERNEL_CS;
     tf.tf_ds = tf.tf_es = tf.tf_ss = KERNEL_DS;
+    tf.tf_gs = GD_CPU;
     tf.tf_regs.reg_ebx = (uint32_t)fn;
     tf.tf_regs.reg_edx = (uint32_t)arg;
     tf.tf_eip = (uint32_t)kernel_thread_entry;
     return do_fork(clone_flags | CLONE_VM, 0, &tf);
 }
 
-// 为进程分配内核栈8KB，用于用户进程中断用
+// 为进程分配内核栈8KB，用于用户进程中断用，先从缓存里拿
 static int setup_kstack(struct proc_struct *proc)
 {
+    bool intr_flag;
+    local_intr_save(intr_flag);
+    if (proc_cache_stats.kstacks_cached > 0)
+    {
+        proc->kstack = kstack_cache[--proc_cache_stats.kstacks_cached];
+        proc_cache_stats.kstack_hits++;
+        local_intr_restore(intr_flag);
+        return 0;
+    }
+    proc_cache_stats.kstack_misses++;
+    local_intr_restore(intr_flag);
+
     struct page_desc *page = alloc_pages(KSTACK_PAGE);
     if (page != NULL)
     {
@@ -247,10 +360,19 @@ static int setup_kstack(struct proc_struct *proc)
     return -E_NO_MEM;
 }
 
-// put_kstack - free the memory space of process kernel stack
+// put_kstack - free the memory space of process kernel stack, or keep it in the cache
 static void
 put_kstack(struct proc_struct *proc)
 {
+    bool intr_flag;
+    local_intr_save(intr_flag);
+    if (proc_cache_stats.kstacks_cached < PROC_CACHE_MAX)
+    {
+        kstack_cache[proc_cache_stats.kstacks_cached++] = proc->kstack;
+        local_intr_restore(intr_flag);
+        return;
+    }
+    local_intr_restore(intr_flag);
     free_pages(kva2page((void *)(proc->kstack)), KSTACK_PAGE);
 }
 
@@ -396,10 +518,63 @@ static void copy_thread(struct proc_struct *proc, uintptr_t esp, struct trap_fra
  * @stack:       the parent's user stack pointer. if stack==0, It means to fork a kernel thread.
  * @tf:          the trapframe info, which will be copied to child process's proc->tf
  */
+/* *
+ * vfork_wait - sleep until the vfork child @proc stops using our mm. The sleep
+ * can't be interrupted: a killed parent would otherwise let init reap the child
+ * while it still points back to us. The child can't be reaped meanwhile
+ * either, since only we wait for it.
+ * */
+static void vfork_wait(struct proc_struct *proc)
+{
+    bool intr_flag;
+    local_intr_save(intr_flag);
+    while (proc->flags & PF_VFORK)
+    {
+        g_cur_proc->state = PROC_SLEEPING;
+        g_cur_proc->wait_state = WT_VFORK;
+        local_intr_restore(intr_flag);
+        schedule();
+        local_intr_save(intr_flag);
+    }
+    local_intr_restore(intr_flag);
+}
+
+// vfork出来的子进程不再用父进程的虚拟空间了，让父进程继续运行
+static void vfork_release(void)
+{
+    bool intr_flag;
+    local_intr_save(intr_flag);
+    if (g_cur_proc->flags & PF_VFORK)
+    {
+        g_cur_proc->flags &= ~PF_VFORK;
+        struct proc_struct *parent = g_cur_proc->parent;
+        if (parent->state == PROC_SLEEPING && parent->wait_state == WT_VFORK)
+        {
+            wakeup_proc(parent);
+        }
+    }
+    local_intr_restore(intr_flag);
+}
+
 int do_fork(uint32_t clone_flags, uintptr_t stack, struct trap_frame *tf)
 {
-    int ret = -E_NO_FREE_PROC;
+    int ret = -E_INVAL;
     struct proc_struct *proc;
+    // 同一个线程组的线程共享虚拟空间和打开的文件
+    if (clone_flags & CLONE_THREAD)
+    {
+        if (!(clone_flags & CLONE_VM))
+        {
+            goto fork_out;
+        }
+        clone_flags |= CLONE_FS;
+    }
+    // vfork的子进程直接用父进程的虚拟空间
+    if ((clone_flags & CLONE_VFORK) && (clone_flags & (CLONE_THREAD | CLONE_SPAWN)))
+    {
+        goto fork_out;
+    }
+    ret = -E_NO_FREE_PROC;
     if (n_process >= MAX_PROCESS)
     {
         goto fork_out;
@@ -412,6 +587,14 @@ int do_fork(uint32_t clone_flags, uintptr_t stack, struct trap_frame *tf)
     }
 
     proc->parent = g_cur_proc;
+    if (clone_flags & CLONE_VFORK)
+    {
+        clone_flags |= CLONE_VM;
+        proc->flags |= PF_VFORK;
+    }
+    proc->priority = g_cur_proc->priority;
+    proc->nice = g_cur_proc->nice;
+    proc->cpus_allowed = g_cur_proc->cpus_allowed;
 
     if (setup_kstack(proc) != 0)
     {
@@ -424,13 +607,17 @@ int do_fork(uint32_t clone_flags, uintptr_t stack, struct trap_frame *tf)
         goto bad_fork_cleanup_kstack;
     }
 
-    // 拷贝父进程的虚拟空间
-    if (copy_mm(clone_flags, proc) != 0)
+    // 拷贝父进程的虚拟空间，spawn出来的子进程会装入新的程序，不需要拷贝
+    if (!(clone_flags & CLONE_SPAWN) && copy_mm(clone_flags, proc) != 0)
     {
         goto bad_fork_cleanup_fs;
     }
 
     copy_thread(proc, stack, tf);
+    if (clone_flags & CLONE_SPAWN)
+    {
+        proc->context.eip = (uintptr_t)spawn_ret;
+    }
 
     bool intr_flag;
     local_intr_save(intr_flag);
@@ -438,12 +625,20 @@ int do_fork(uint32_t clone_flags, uintptr_t stack, struct trap_frame *tf)
         proc->pid = get_pid();
         hash_proc(proc);
         set_links(proc);
+        if (clone_flags & CLONE_THREAD)
+        {
+            list_add(&(g_cur_proc->thread_group), &(proc->thread_group));
+        }
     }
     local_intr_restore(intr_flag);
 
     wakeup_proc(proc);
 
     ret = proc->pid;
+    if (clone_flags & CLONE_VFORK)
+    {
+        vfork_wait(proc);
+    }
 fork_out:
     return ret;
 
@@ -452,7 +647,7 @@ bad_fork_cleanup_fs:
 bad_fork_cleanup_kstack:
     put_kstack(proc);
 bad_fork_cleanup_proc:
-    kfree(proc);
+    free_proc(proc);
     goto fork_out;
 }
 
@@ -474,9 +669,9 @@ int do_exit(int error_code)
     struct mm_struct *mm = g_cur_proc->mm;
     if (mm != NULL)
     {
-        lcr3(g_boot_cr3);
-        mm->map_count--;
-        if (mm->map_count == 0)
+        cpu_load_cr3(g_boot_cr3);
+        mm->mm_count--;
+        if (mm->mm_count == 0)
         {
             exit_mmap(mm);
             put_pgdir(mm);
@@ -484,6 +679,9 @@ int do_exit(int error_code)
         }
         g_cur_proc->mm = NULL;
     }
+    vfork_release();
+    // 释放实时进程占用的CPU份额
+    edf_set_params(g_cur_proc, 0, 0, 0);
     g_cur_proc->state = PROC_ZOMBIE;
     g_cur_proc->exit_code = error_code;
 
@@ -523,6 +721,53 @@ int do_exit(int error_code)
     panic("do_exit will not return!! %d.\n", g_cur_proc->pid);
 }
 
+// 让当前进程所在线程组里的其它线程退出，它们回到用户态之前或者从睡眠里醒来时会用error_code调用do_exit
+static void kill_other_threads(int error_code)
+{
+    bool intr_flag;
+    local_intr_save(intr_flag);
+    {
+        list_entry_t *list = &(g_cur_proc->thread_group), *le = list;
+        while ((le = list_next(le)) != list)
+        {
+            struct proc_struct *proc = le2proc(le, thread_group);
+            if (proc->state != PROC_ZOMBIE && !(proc->flags & PF_EXITING))
+            {
+                proc->flags |= PF_EXITING;
+                // 主线程也是这样退出的，父进程wait到的是整个线程组的退出码
+                proc->exit_code = error_code;
+                if (proc->wait_state & WT_INTERRUPTED)
+                {
+                    wakeup_proc(proc);
+                }
+            }
+        }
+    }
+    local_intr_restore(intr_flag);
+}
+
+// do_exit_group - called by sys_exit, the whole thread group of current process exits
+int do_exit_group(int error_code)
+{
+    kill_other_threads(error_code);
+    return do_exit(error_code);
+}
+
+// 把proc自己和它的子孙进程的资源使用加到sum上
+static void rusage_add(struct rusage *sum, struct proc_struct *proc)
+{
+    struct rusage ru, *child = &(proc->child_rusage);
+    proc_rusage(proc, &ru);
+    sum->ru_utime += ru.ru_utime + child->ru_utime;
+    sum->ru_stime += ru.ru_stime + child->ru_stime;
+    sum->ru_nvcsw += ru.ru_nvcsw + child->ru_nvcsw;
+    sum->ru_nivcsw += ru.ru_nivcsw + child->ru_nivcsw;
+    sum->ru_minflt += ru.ru_minflt + child->ru_minflt;
+    sum->ru_majflt += ru.ru_majflt + child->ru_majflt;
+    sum->ru_read_bytes += ru.ru_read_bytes + child->ru_read_bytes;
+    sum->ru_write_bytes += ru.ru_write_bytes + child->ru_write_bytes;
+}
+
 // do_wait - wait one OR any children with PROC_ZOMBIE state, and free memory space of kernel stack
 //         - proc struct of this child.
 // NOTE: only after do_wait function, all resources of the child proces are free.
@@ -572,7 +817,7 @@ repeat:
         schedule();
         if (g_cur_proc->flags & PF_EXITING)
         {
-            do_exit(-E_KILLED);
+            do_exit(g_cur_proc->exit_code);
         }
         goto repeat;
     }
@@ -589,12 +834,16 @@ found:
     }
     local_intr_save(intr_flag);
     {
+        // 子进程和它回收的子孙进程的资源使用都算到父进程的子进程总和里
+        rusage_add(&(g_cur_proc->child_rusage), proc);
         unhash_proc(proc);
         remove_links(proc);
+        list_del(&(proc->thread_group));
+        put_pid(proc->pid);
     }
     local_intr_restore(intr_flag);
     put_kstack(proc);
-    kfree(proc);
+    free_proc(proc);
     return 0;
 }
 
@@ -775,7 +1024,7 @@ load_icode(int fd, int argc, char **kargv)
     mm->mm_count++;
     g_cur_proc->mm = mm;
     g_cur_proc->cr3 = PADDR(mm->pgdir);
-    lcr3(PADDR(mm->pgdir));
+    cpu_load_cr3(PADDR(mm->pgdir));
 
     // setup argc, argv
     uint32_t argv_size = 0, i;
@@ -859,6 +1108,28 @@ failed_cleanup:
     return ret;
 }
 
+// 把程序名和参数从用户空间拷贝到内核里，成功以后由调用者put_kargv
+static int copy_exec_args(struct mm_struct *mm, const char *name, char *local_name,
+                          int argc, char **kargv, const char **argv)
+{
+    int ret = -E_INVAL;
+    memset(local_name, 0, PROC_NAME_LEN + 1);
+
+    lock_mm(mm);
+    if (name == NULL)
+    {
+        snprintf(local_name, PROC_NAME_LEN + 1, "<null> %d", g_cur_proc->pid);
+    }
+    else if (!copy_string(mm, local_name, name, PROC_NAME_LEN + 1))
+    {
+        goto out;
+    }
+    ret = copy_kargv(mm, argc, kargv, argv);
+out:
+    unlock_mm(mm);
+    return ret;
+}
+
 // do_execve - call exit_mmap(mm)&put_pgdir(mm) to reclaim memory space of current process
 //           - call load_icode to setup new memory space accroding binary prog.
 int do_execve(const char *name, int argc, const char **argv)
@@ -871,33 +1142,18 @@ int do_execve(const char *name, int argc, const char **argv)
     }
 
     char local_name[PROC_NAME_LEN + 1];
-    memset(local_name, 0, sizeof(local_name));
-
     char *kargv[EXEC_MAX_ARG_NUM];
-    const char *path;
-
-    int ret = -E_INVAL;
+    const char *path = argv[0];
 
-    lock_mm(mm);
-    if (name == NULL)
-    {
-        snprintf(local_name, sizeof(local_name), "<null> %d", g_cur_proc->pid);
-    }
-    else
-    {
-        if (!copy_string(mm, local_name, name, sizeof(local_name)))
-        {
-            unlock_mm(mm);
-            return ret;
-        }
-    }
-    if ((ret = copy_kargv(mm, argc, kargv, argv)) != 0)
+    int ret;
+    if ((ret = copy_exec_args(mm, name, local_name, argc, kargv, argv)) != 0)
     {
-        unlock_mm(mm);
         return ret;
     }
-    path = argv[0];
-    unlock_mm(mm);
+
+    // 换成新的程序以后不再和其它线程共享虚拟空间
+    kill_other_threads(-E_KILLED);
+    list_del_init(&(g_cur_proc->thread_group));
     files_closeall(g_cur_proc->filesp);
 
     /* sysfile_open will check the first argument path, thus we have to use a user-space pointer, and argv[0] may be incorrect */
@@ -908,7 +1164,7 @@ int do_execve(const char *name, int argc, const char **argv)
     }
     if (mm != NULL)
     {
-        lcr3(g_boot_cr3);
+        cpu_load_cr3(g_boot_cr3);
         mm->mm_count--;
         if (mm->mm_count == 0)
         {
@@ -918,6 +1174,7 @@ int do_execve(const char *name, int argc, const char **argv)
         }
         g_cur_proc->mm = NULL;
     }
+    vfork_release();
     ret = -E_NO_MEM;
     ;
     if ((ret = load_icode(fd, argc, kargv)) != 0)
@@ -934,6 +1191,94 @@ execve_exit:
     panic("already exit: %e.\n", ret);
 }
 
+// spawn出来的子进程要装入的程序，由父进程准备好，子进程用完以后释放
+struct spawn_args
+{
+    int fd;
+    int argc;
+    char *kargv[EXEC_MAX_ARG_NUM];
+    char name[PROC_NAME_LEN + 1];
+};
+
+/* *
+ * spawn_ret - the first kernel entry point of a spawned process. It has no
+ * mm yet, so it loads the program opened by the parent here, on its own kernel
+ * stack below the trap frame, and then returns to user mode like forkret.
+ * */
+static void spawn_ret(void)
+{
+    struct spawn_args *args = (struct spawn_args *)(g_cur_proc->tf->tf_regs.reg_ebx);
+    // 和内核线程一样开中断运行，读文件时可能会睡眠
+    intr_enable();
+    int ret = load_icode(args->fd, args->argc, args->kargv);
+    if (ret == 0)
+    {
+        set_proc_name(g_cur_proc, args->name);
+    }
+    put_kargv(args->argc, args->kargv);
+    kfree(args);
+    if (ret != 0)
+    {
+        do_exit(ret);
+    }
+    intr_disable();
+    forkret();
+}
+
+/* *
+ * do_spawn - create a child process running the program argv[0], without
+ * copying the address space of current process the way fork+exec does. The
+ * child shares nothing but a copy of the open files. Errors finding the file
+ * or copying the arguments are returned here, while a bad ELF makes the
+ * child exit with the error code.
+ * */
+int do_spawn(const char *name, int argc, const char **argv)
+{
+    struct mm_struct *mm = g_cur_proc->mm;
+    if (!(argc >= 1 && argc <= EXEC_MAX_ARG_NUM))
+    {
+        return -E_INVAL;
+    }
+
+    struct spawn_args *args;
+    if ((args = kmalloc(sizeof(struct spawn_args))) == NULL)
+    {
+        return -E_NO_MEM;
+    }
+    int ret;
+    if ((ret = copy_exec_args(mm, name, args->name, argc, args->kargv, argv)) != 0)
+    {
+        goto out_free;
+    }
+    args->argc = argc;
+
+    // 在父进程里打开文件，子进程拷贝文件表时得到同一个fd
+    int fd;
+    if ((ret = fd = sysfile_open(argv[0], O_RDONLY)) < 0)
+    {
+        goto out_put_kargv;
+    }
+    args->fd = fd;
+
+    // 子进程的中断帧会被load_icode重写，这里只用它把args传给spawn_ret
+    struct trap_frame tf;
+    memset(&tf, 0, sizeof(struct trap_frame));
+    tf.tf_regs.reg_ebx = (uint32_t)args;
+    ret = do_fork(CLONE_SPAWN, 0, &tf);
+    // 子进程可能已经开始运行并释放了args
+    sysfile_close(fd);
+    if (ret > 0)
+    {
+        return ret;
+    }
+
+out_put_kargv:
+    put_kargv(argc, args->kargv);
+out_free:
+    kfree(args);
+    return ret;
+}
+
 // do_yield - ask the scheduler to reschedule
 int do_yield(void)
 {
@@ -950,6 +1295,7 @@ int do_kill(int pid)
         if (!(proc->flags & PF_EXITING))
         {
             proc->flags |= PF_EXITING;
+            proc->exit_code = -E_KILLED;
             if (proc->wait_state & WT_INTERRUPTED)
             {
                 wakeup_proc(proc);
@@ -961,6 +1307,172 @@ int do_kill(int pid)
     return -E_INVAL;
 }
 
+// do_sleep - set current process state to sleep and add timer with "time"
+//          - then call scheduler. if process run again, delete timer first.
+int do_sleep(unsigned int time)
+{
+    if (time == 0)
+    {
+        return 0;
+    }
+    bool intr_flag;
+    local_intr_save(intr_flag);
+    timer_t __timer, *timer = timer_init(&__timer, g_cur_proc, time);
+    g_cur_proc->state = PROC_SLEEPING;
+    g_cur_proc->wait_state = WT_TIMER;
+    add_timer(timer);
+    local_intr_restore(intr_flag);
+
+    schedule();
+
+    // 被kill唤醒的时候定时器还没到期
+    del_timer(timer);
+    return 0;
+}
+
+// pid为0时表示当前进程
+static struct proc_struct *find_proc_or_current(int pid)
+{
+    return (pid == 0) ? g_cur_proc : find_proc(pid);
+}
+
+/* *
+ * do_setpriority - set the priority of process @pid (0 for current), which
+ * is its weight in the stride scheduler: a process of priority 2 gets twice
+ * the CPU of one of priority 1. The cfs scheduler uses the nice value with
+ * the nearest weight, and the mlfq scheduler doesn't let the process sink
+ * below level MLFQ_NLEVELS - 1 - log2(priority). Children inherit the priority.
+ * */
+int do_setpriority(int pid, int priority)
+{
+    struct proc_struct *proc;
+    if (priority < 1 || priority > PRIORITY_MAX || (proc = find_proc_or_current(pid)) == NULL)
+    {
+        return -E_INVAL;
+    }
+    // stride调度器只在选中进程时才用到优先级，cfs只在tick里用到nice，所以在队列里也可以直接改
+    proc->priority = priority;
+    proc->nice = cfs_priority_to_nice(priority);
+    return 0;
+}
+
+// do_getpriority - get the priority of process @pid (0 for current)
+int do_getpriority(int pid)
+{
+    struct proc_struct *proc;
+    if ((proc = find_proc_or_current(pid)) == NULL)
+    {
+        return -E_INVAL;
+    }
+    return proc->priority;
+}
+
+// do_schedstat - copy the scheduling statistics of process @pid (0 for current) to user space
+int do_schedstat(int pid, struct schedstat *store)
+{
+    struct proc_struct *proc;
+    if ((proc = find_proc_or_current(pid)) == NULL)
+    {
+        return -E_INVAL;
+    }
+
+    struct schedstat stat;
+    bool intr_flag;
+    local_intr_save(intr_flag);
+    {
+        stat.sc_runs = proc->runs;
+        stat.sc_run_ticks = proc->run_ticks;
+        stat.sc_wait_ticks = proc->wait_ticks;
+        stat.sc_nvcsw = proc->nvcsw;
+        stat.sc_nivcsw = proc->nivcsw;
+        stat.sc_migrations = proc->migrations;
+        stat.sc_cpu = (proc->rq != NULL) ? proc->rq->cpu->id : 0;
+    }
+    local_intr_restore(intr_flag);
+
+    if (!copy_to_user(g_cur_proc->mm, store, &stat, sizeof(struct schedstat)))
+    {
+        return -E_INVAL;
+    }
+    return 0;
+}
+
+// proc_rusage - the resource usage of @proc itself, without its children
+void proc_rusage(struct proc_struct *proc, struct rusage *ru)
+{
+    ru->ru_utime = proc->utime;
+    ru->ru_stime = proc->stime;
+    ru->ru_nvcsw = proc->nvcsw;
+    ru->ru_nivcsw = proc->nivcsw;
+    ru->ru_minflt = proc->minflt;
+    ru->ru_majflt = proc->majflt;
+    ru->ru_read_bytes = proc->read_bytes;
+    ru->ru_write_bytes = proc->write_bytes;
+}
+
+/* *
+ * do_getrusage - copy the resource usage of current process (RUSAGE_SELF),
+ * or the sum over its reaped children and their reaped descendants
+ * (RUSAGE_CHILDREN), to user space.
+ * */
+int do_getrusage(int who, struct rusage *store)
+{
+    struct rusage ru;
+    bool intr_flag;
+    local_intr_save(intr_flag);
+    if (who == RUSAGE_SELF)
+    {
+        proc_rusage(g_cur_proc, &ru);
+    }
+    else if (who == RUSAGE_CHILDREN)
+    {
+        ru = g_cur_proc->child_rusage;
+    }
+    else
+    {
+        local_intr_restore(intr_flag);
+        return -E_INVAL;
+    }
+    local_intr_restore(intr_flag);
+
+    if (!copy_to_user(g_cur_proc->mm, store, &ru, sizeof(struct rusage)))
+    {
+        return -E_INVAL;
+    }
+    return 0;
+}
+
+/* *
+ * do_sched_setaffinity - restrict process @pid (0 for current) to the CPUs in
+ * @mask, bit i for cpu i. CPUs which are not online are ignored, and a mask
+ * without any online CPU is rejected. Children inherit the mask.
+ * */
+int do_sched_setaffinity(int pid, uint32_t mask)
+{
+    struct proc_struct *proc;
+    if ((proc = find_proc_or_current(pid)) == NULL)
+    {
+        return -E_INVAL;
+    }
+    return sched_set_affinity(proc, mask);
+}
+
+// do_sched_getaffinity - get the online CPUs which process @pid (0 for current) may run on
+int do_sched_getaffinity(int pid, uint32_t *mask_store)
+{
+    struct proc_struct *proc;
+    if ((proc = find_proc_or_current(pid)) == NULL)
+    {
+        return -E_INVAL;
+    }
+    uint32_t mask = proc->cpus_allowed & cpu_online_mask();
+    if (!copy_to_user(g_cur_proc->mm, mask_store, &mask, sizeof(uint32_t)))
+    {
+        return -E_INVAL;
+    }
+    return 0;
+}
+
 // kernel_execve - do SYS_exec syscall to exec a user program called by user_main kernel_thread
 static int kernel_execve(const char *name, const char **argv)
 {
@@ -1007,6 +1519,12 @@ int init_main(void *arg)
     {
         panic("set boot fs failed: %e.\n", ret);
     }
+    // 文件系统里有预先分配好的交换文件就启用它
+    if ((ret = swapfs_swapon(SWAP_FILE)) != 0 && ret != -E_NOENT)
+    {
+        cprintf("swapon %s failed: %e.\n", SWAP_FILE, ret);
+    }
+    swap_selftest();
 
     size_t n_free_pages_store = n_free_pages();
     size_t kernel_allocated_store = kallocated();
@@ -1022,6 +1540,7 @@ int init_main(void *arg)
         schedule();
     }
 
+    swapfs_cleanup();
     fs_cleanup();
 
     cprintf("all user-mode processes have quit.\n");
@@ -1043,6 +1562,7 @@ void proc_init(void)
     {
         list_init(g_hash_list + i);
     }
+    set_bit(0, g_pid_map);
 
     if ((g_idle_proc = alloc_proc()) == NULL)
     {
@@ -1075,15 +1595,36 @@ void proc_init(void)
     set_proc_name(g_init_proc, "init");
 }
 
+// proc_create_idle - create the idle process of an AP, which runs on its own kernel stack
+struct proc_struct *proc_create_idle(struct cpu *cpu)
+{
+    struct proc_struct *idle;
+    if ((idle = alloc_proc()) == NULL)
+    {
+        return NULL;
+    }
+    if (setup_kstack(idle) != 0)
+    {
+        kfree(idle);
+        return NULL;
+    }
+
+    // 和BSP的idle进程一样是第0号进程，不在进程列表里
+    idle->pid = 0;
+    idle->state = PROC_RUNNABLE;
+    idle->need_resched = 1;
+    set_proc_name(idle, "idle");
+    cpu->idle_proc = cpu->cur_proc = idle;
+    return idle;
+}
+
 // cpu_idle - at the end of kern_init, the first kernel thread g_idle_proc will do below works
 void cpu_idle(void)
 {
     while (1)
     {
-        // if (g_cur_proc->need_resched)
-        // {
-        cprintf("idle proc\n");
+        // 没有可运行的进程时停在这里，直到有中断把进程唤醒
+        sched_idle();
         schedule();
-        // }
     }
 }
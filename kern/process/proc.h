@@ -6,8 +6,13 @@
 #include "kern/trap/trap.h"
 #include "kern/mm/vmm.h"
 #include "libs/skew_heap.h"
+#include "libs/rb_tree.h"
+#include "kern/schedule/timer.h"
+#include "kern/process/cpu.h"
 #include "kern/schedule/sched.h"
 #include "kern/fs/fs.h"
+#include "libs/schedstat.h"
+#include "libs/rusage.h"
 
 /* fork flags used in do_fork*/
 #define CLONE_VM 0x00000100     // set if VM shared between processes
@@ -42,12 +47,15 @@ struct context
 #define MAX_PID (MAX_PROCESS * 2)
 
 #define PF_EXITING 0x00000001 // getting shutdown
+#define PF_VFORK 0x00000002   // vfork出来的子进程，父进程在等它exec或者exit
 
 #define WT_INTERRUPTED 0x80000000              // the wait state could be interrupted
 #define WT_CHILD (0x00000001 | WT_INTERRUPTED) // wait child process
 #define WT_KSEM 0x00000100                     // wait kernel semaphore
 #define WT_TIMER (0x00000002 | WT_INTERRUPTED) // wait timer
 #define WT_KBD (0x00000004 | WT_INTERRUPTED)   // wait the input of keyboard
+#define WT_FUTEX (0x00000008 | WT_INTERRUPTED) // wait user futex
+#define WT_VFORK 0x00000200                    // wait vfork child to exec or exit
 
 extern list_entry_t g_proc_list;
 
@@ -67,7 +75,7 @@ struct proc_struct
     char name[PROC_NAME_LEN + 1]; // 进程名
     list_entry_t list_link;       // Process link list
     list_entry_t hash_link;       // Process hash list
-    int exit_code;                // 退出的时候的代码
+    int exit_code;                // 退出的时候的代码，被杀掉的进程在设置PF_EXITING时就填好
     uint32_t wait_state;          // waiting state
     struct proc_struct *cptr;     // child 子进程
     struct proc_struct *yptr;     // younger sibling 左边的兄弟
@@ -78,16 +86,61 @@ struct proc_struct
     skew_heap_entry_t run_pool;   // the entry in the run pool
     uint32_t stride;              // 进程的步进值，越小的越先被调度，每次调度就加上进程的优先级（stride调度算法）
     uint32_t priority;            // 进程的优先级
+    int mlfq_level;               // 在多级反馈队列里的级别，0最高
+    rb_node_t cfs_node;           // 在cfs调度器红黑树里的节点
+    uint32_t vruntime;            // cfs调度器里的虚拟运行时间
+    int nice;                     // nice值，NICE_MIN~NICE_MAX，越小权重越大
+    uint32_t dl_runtime;          // 实时进程每个周期的运行时间，dl_period为0的是普通进程
+    uint32_t dl_deadline;         // 实时进程从周期开始到截止时间的tick数
+    uint32_t dl_period;           // 实时进程的周期
+    uint32_t dl_abs_deadline;     // 当前周期的绝对截止时间
+    int dl_remaining;             // 当前周期剩下的运行时间
+    bool dl_throttled;            // 当前周期的运行时间是否已经用完
+    rb_node_t dl_node;            // 在edf调度器红黑树里的节点
+    timer_t dl_timer;             // 下个周期开始时补充运行时间的定时器
+    uint32_t run_ticks;           // 在CPU上运行的tick数
+    uint32_t wait_ticks;          // 在运行队列里等待的tick数
+    uint32_t wait_start;          // 最近一次进入运行队列的时间
+    uint32_t nvcsw;               // 主动让出CPU的次数
+    uint32_t nivcsw;              // 被抢占的次数
+    uint32_t migrations;          // 被负载均衡迁移到别的CPU的次数
+    uint32_t cpus_allowed;        // 允许运行的CPU的掩码
     struct files_struct *filesp;  // 进程的打开文件信息
+    list_entry_t thread_group;    // 共享同一个mm的线程组成的链表
+    uint32_t utime;               // 在用户态运行的tick数
+    uint32_t stime;               // 在内核态运行的tick数
+    uint32_t minflt;              // 本进程引起的不需要读交换磁盘的缺页次数
+    uint32_t majflt;              // 本进程引起的需要读交换磁盘的缺页次数
+    uint64_t read_bytes;          // 读文件的字节数
+    uint64_t write_bytes;         // 写文件的字节数
+    struct rusage child_rusage;   // 已回收的子孙进程的资源使用总和
 };
 
 #define le2proc(le, member) \
     to_struct((le), struct proc_struct, member)
 
-extern struct proc_struct *g_idle_proc, *g_init_proc, *g_cur_proc;
+extern struct proc_struct *g_init_proc;
+
+// 每个CPU有自己的当前进程和idle进程
+#define g_cur_proc (this_cpu()->cur_proc)
+#define g_idle_proc (this_cpu()->idle_proc)
+
+// proc_struct和内核栈缓存的统计
+struct proc_cache_stat
+{
+    uint32_t proc_hits;   // 从缓存里拿到proc_struct的次数
+    uint32_t proc_misses; // 缓存空了用kmalloc的次数
+    uint32_t kstack_hits;
+    uint32_t kstack_misses;
+    int procs_cached; // 缓存里现有的个数
+    int kstacks_cached;
+};
 
 void proc_init(void);
+void proc_cache_stat(struct proc_cache_stat *stat);
+struct proc_struct *proc_create_idle(struct cpu *cpu);
 void proc_run(struct proc_struct *proc);
+void __proc_run(struct proc_struct *next);
 int kernel_thread(int (*fn)(void *), void *arg, uint32_t clone_flags);
 
 char *set_proc_name(struct proc_struct *proc, const char *name);
@@ -96,6 +149,16 @@ void cpu_idle(void);
 
 struct proc_struct *find_proc(int pid);
 int do_fork(uint32_t clone_flags, uintptr_t stack, struct trap_frame *tf);
+int do_spawn(const char *name, int argc, const char **argv);
 int do_exit(int error_code);
+int do_exit_group(int error_code);
+int do_sleep(unsigned int time);
+int do_setpriority(int pid, int priority);
+int do_getpriority(int pid);
+int do_schedstat(int pid, struct schedstat *store);
+int do_sched_setaffinity(int pid, uint32_t mask);
+int do_sched_getaffinity(int pid, uint32_t *mask_store);
+void proc_rusage(struct proc_struct *proc, struct rusage *ru);
+int do_getrusage(int who, struct rusage *store);
 
 #endif /* !__KERN_PROCESS_PROC_H__ */
@@ -3,37 +3,195 @@
 #include "libs/list.h"
 #include "kern/sync/sync.h"
 #include "kern/schedule/sched_stride.h"
+#include "kern/schedule/sched_mlfq.h"
+#include "kern/schedule/sched_cfs.h"
+#include "kern/schedule/sched_edf.h"
+#include "kern/schedule/sched_trace.h"
+#include "kern/mm/kmalloc.h"
+#include "libs/stdlib.h"
 #include "kern/driver/stdio.h"
+#include "kern/driver/clock.h"
+#include "kern/driver/intr.h"
+#include "libs/x86.h"
+#include "libs/string.h"
+#include "libs/error.h"
 
-static list_entry_t g_timer_list;         // 定时器列表
-static struct sched_class *g_sched_class; // 调度器
-static struct run_queue *g_rq;            // 运行队列
-static struct run_queue __rq;
+static struct sched_class *g_sched_class; // 普通进程的调度器
+static struct run_queue __rq[NCPU];       // 每个CPU一个运行队列
+
+#define g_rq (this_cpu()->rq) // 当前CPU的运行队列
+
+// 所有的调度器，第一个是默认的
+static struct sched_class *sched_classes[] = {
+    &g_stride_sched_class,
+    &g_mlfq_sched_class,
+    &g_cfs_sched_class,
+};
+
+#define NSCHED_CLASSES (sizeof(sched_classes) / sizeof(sched_classes[0]))
+
+// 进程所属的调度器，设置了实时参数的进程归edf调度器管
+static inline struct sched_class *
+proc_sched_class(struct proc_struct *proc)
+{
+    return (proc->dl_period != 0) ? &g_edf_sched_class : g_sched_class;
+}
+
+// 队列的负载：排队的进程数加上正在运行的进程
+static inline unsigned int
+rq_load(struct run_queue *rq)
+{
+    return rq->proc_num + (rq->cpu->cur_proc != rq->cpu->idle_proc);
+}
+
+// 进程不能留在原来的CPU上时，找掩码里负载最轻的CPU
+static struct run_queue *
+sched_select_rq_slow(struct proc_struct *proc)
+{
+    struct run_queue *rq = NULL;
+    for (int i = 0; i < g_ncpu; i++)
+    {
+        struct cpu *cpu = g_cpus + i;
+        if (cpu->started && (proc->cpus_allowed & cpu_mask(cpu)) &&
+            (rq == NULL || rq_load(cpu->rq) < rq_load(rq)))
+        {
+            rq = cpu->rq;
+        }
+    }
+    // sched_set_affinity保证掩码里至少有一个启动了的CPU
+    assert(rq != NULL);
+    return rq;
+}
+
+/* *
+ * sched_select_rq - choose a run queue for @proc: the CPU it ran on last time
+ * if it's still allowed, otherwise the least loaded CPU in its affinity mask.
+ * */
+static inline struct run_queue *
+sched_select_rq(struct proc_struct *proc)
+{
+    if (proc->rq != NULL && (proc->cpus_allowed & cpu_mask(proc->rq->cpu)))
+    {
+        return proc->rq;
+    }
+    return sched_select_rq_slow(proc);
+}
 
 static inline void
 sched_class_enqueue(struct proc_struct *proc)
 {
-    g_sched_class->enqueue(g_rq, proc);
+    struct cpu *cpu = this_cpu();
+    // idle进程不进运行队列，队列空了才会选它
+    if (proc != cpu->idle_proc)
+    {
+        struct run_queue *rq = sched_select_rq(proc);
+        proc->wait_start = g_ticks;
+        proc_sched_class(proc)->enqueue(rq, proc);
+        // 放到了别的CPU上，它可能正在停机，或者enqueue要抢占那边正在运行的进程
+        struct proc_struct *cur = rq->cpu->cur_proc;
+        if (rq->cpu != cpu && (cur == rq->cpu->idle_proc || cur->need_resched))
+        {
+            cpu_kick(rq->cpu);
+        }
+    }
 }
 
 static inline void
 sched_class_dequeue(struct proc_struct *proc)
 {
-    g_sched_class->dequeue(g_rq, proc);
+    proc->wait_ticks += g_ticks - proc->wait_start;
+    proc_sched_class(proc)->dequeue(proc->rq, proc);
 }
 
+// 按优先级从高到低询问各个调度器，实时进程总是先于普通进程运行
 static inline struct proc_struct *
-sched_class_pick_next(void)
+sched_class_pick_next(struct run_queue *rq)
 {
-    return g_sched_class->pick_next(g_rq);
+    // 队列空了或者没有实时进程时不用调用对应的调度器
+    if (rq->proc_num == 0)
+    {
+        return NULL;
+    }
+    struct proc_struct *next;
+    if (!rb_tree_empty(&(rq->edf_tree)) && (next = g_edf_sched_class.pick_next(rq)) != NULL)
+    {
+        return next;
+    }
+    return g_sched_class->pick_next(rq);
+}
+
+/* *
+ * sched_balance - pull processes of the fair class from the busiest CPU to the
+ * run queue @rq of the current CPU. An idle CPU steals one process whatever its
+ * cache state is. The periodic balancer only moves processes when the busiest
+ * CPU has at least SCHED_IMBALANCE more of them, and only those which have
+ * waited for SCHED_MIGRATION_COST ticks. Returns the number of processes moved.
+ * */
+static int
+sched_balance(struct run_queue *rq, bool idle)
+{
+    struct run_queue *busiest = NULL;
+    for (int i = 0; i < g_ncpu; i++)
+    {
+        struct run_queue *src = g_cpus[i].rq;
+        if (src != rq && g_cpus[i].started && src->proc_num != 0 &&
+            (busiest == NULL || rq_load(src) > rq_load(busiest)))
+        {
+            busiest = src;
+        }
+    }
+    if (busiest == NULL)
+    {
+        return 0;
+    }
+
+    int n = 1;
+    uint32_t min_wait = 0;
+    if (!idle)
+    {
+        unsigned int load = rq_load(rq), max = rq_load(busiest);
+        if (max < load + SCHED_IMBALANCE)
+        {
+            return 0;
+        }
+        // 迁移一半的差值，两边就差不多平了
+        n = (max - load) / 2;
+        if (n > SCHED_MIGRATE_MAX)
+        {
+            n = SCHED_MIGRATE_MAX;
+        }
+        min_wait = SCHED_MIGRATION_COST;
+    }
+
+    // 这个CPU没事可做时，连busiest马上要运行的进程也可以拿过来
+    bool take_next = idle || rq_load(rq) == 0;
+    struct proc_struct *procs[SCHED_MIGRATE_MAX];
+    n = g_sched_class->get_proc(busiest, rq, procs, n, min_wait, take_next);
+    for (int i = 0; i < n; i++)
+    {
+        // 还在等待，wait_start不变
+        procs[i]->migrations++;
+        g_sched_class->enqueue(rq, procs[i]);
+    }
+    return n;
 }
 
 static void
-sched_class_proc_tick(struct proc_struct *proc)
+sched_class_proc_tick(struct proc_struct *proc, bool in_user)
 {
+    proc->run_ticks++;
+    // 按时钟中断打断的是用户态还是内核态记账
+    if (in_user)
+    {
+        proc->utime++;
+    }
+    else
+    {
+        proc->stime++;
+    }
     if (proc != g_idle_proc)
     {
-        g_sched_class->proc_tick(g_rq, proc);
+        proc_sched_class(proc)->proc_tick(g_rq, proc);
     }
     else
     {
@@ -41,17 +199,140 @@ sched_class_proc_tick(struct proc_struct *proc)
     }
 }
 
+/* *
+ * run_timer_list - called by the timer interrupt on every tick. It wakes up
+ * the processes whose timers expired, and then charges the tick to the
+ * current process through the sched_class, as user time if @in_user says
+ * the interrupt came from user mode and as system time otherwise.
+ * */
+void run_timer_list(bool in_user)
+{
+    bool intr_flag;
+    local_intr_save(intr_flag);
+    {
+        timer_wheel_run(g_ticks);
+        sched_class_proc_tick(g_cur_proc, in_user);
+        if (g_ncpu > 1 && ++g_rq->balance_ticks >= SCHED_BALANCE_TICKS)
+        {
+            g_rq->balance_ticks = 0;
+            sched_balance(g_rq, 0);
+        }
+    }
+    local_intr_restore(intr_flag);
+}
+
+/* *
+ * sched_idle - called by the idle process in a loop. If nothing is runnable,
+ * the CPU halts with the kernel lock released until an interrupt arrives.
+ * On a uniprocessor the periodic tick is also stopped until the next timer,
+ * and the elapsed ticks and expired timers are caught up before returning.
+ * */
+void sched_idle(void)
+{
+    intr_disable();
+    if (g_rq->proc_num == 0 && g_ncpu > 1)
+    {
+        // 其它CPU往这里放进程时会发IPI把我们叫醒
+        kernel_unlock();
+        sti_hlt();
+        intr_disable();
+        kernel_lock();
+    }
+    else if (g_rq->proc_num == 0)
+    {
+        size_t ticks;
+        bool has_timer = timer_wheel_next(g_ticks, &ticks);
+        if (!has_timer || ticks != 0)
+        {
+            clock_set_next_event(has_timer ? ticks : 0);
+            kernel_unlock();
+            sti_hlt();
+            intr_disable();
+            kernel_lock();
+            clock_resume();
+        }
+        timer_wheel_run(g_ticks);
+    }
+    intr_enable();
+}
+
 void sched_init(void)
 {
-    list_init(&g_timer_list);
+    timer_wheel_init();
 
-    g_sched_class = &g_stride_sched_class;
+    // 按名字选择调度器，找不到就用stride
+    g_sched_class = sched_classes[0];
+    for (int i = 0; i < NSCHED_CLASSES; i++)
+    {
+        if (strncmp(sched_classes[i]->name, SCHED_CLASS, strlen(SCHED_CLASS)) == 0)
+        {
+            g_sched_class = sched_classes[i];
+            break;
+        }
+    }
 
-    g_rq = &__rq;
-    g_rq->max_time_slice = MAX_TIME_SLICE;
-    g_sched_class->init(g_rq);
+    for (int i = 0; i < g_ncpu; i++)
+    {
+        struct run_queue *rq = __rq + i;
+        rq->cpu = g_cpus + i;
+        rq->max_time_slice = MAX_TIME_SLICE;
+        g_sched_class->init(rq);
+        g_edf_sched_class.init(rq);
+        g_cpus[i].rq = rq;
+    }
 
-    cprintf("sched class: %s\n", g_sched_class->name);
+    cprintf("sched class: %s, %d cpus\n", g_sched_class->name, g_ncpu);
+}
+
+/* *
+ * sched_set_affinity - set the affinity mask of @proc to the online CPUs in
+ * @mask. If it's on the run queue of a CPU that is no longer allowed, it is
+ * moved to an allowed one at once; if it's running there, that CPU is asked
+ * to reschedule, which puts it on an allowed run queue. A throttled real-time
+ * process is in no queue until its next period, when sched_requeue picks an
+ * allowed one.
+ * */
+int sched_set_affinity(struct proc_struct *proc, uint32_t mask)
+{
+    if ((mask &= cpu_online_mask()) == 0)
+    {
+        return -E_INVAL;
+    }
+
+    bool intr_flag;
+    local_intr_save(intr_flag);
+    {
+        proc->cpus_allowed = mask;
+        struct run_queue *rq = proc->rq;
+        // 被挂起的实时进程只是在等补充运行时间的定时器，并不在队列里，不用动
+        bool throttled = (proc->dl_period != 0 && proc->dl_throttled);
+        if (rq != NULL && !(mask & cpu_mask(rq->cpu)) && proc->state == PROC_RUNNABLE && !throttled)
+        {
+            if (rq->cpu->cur_proc == proc)
+            {
+                proc->need_resched = 1;
+                cpu_kick(rq->cpu);
+            }
+            else
+            {
+                sched_class_dequeue(proc);
+                sched_class_enqueue(proc);
+            }
+            proc->migrations++;
+        }
+    }
+    local_intr_restore(intr_flag);
+    return 0;
+}
+
+/* *
+ * sched_requeue - put the runnable @proc, which is in no run queue and not
+ * running, on a run queue allowed by its affinity mask. Used by the edf
+ * scheduler when a throttled process gets its runtime back.
+ * */
+void sched_requeue(struct proc_struct *proc)
+{
+    sched_class_enqueue(proc);
 }
 
 void wakeup_proc(struct proc_struct *proc)
@@ -68,6 +349,7 @@ void wakeup_proc(struct proc_struct *proc)
             {
                 sched_class_enqueue(proc);
             }
+            sched_trace(SCHED_EV_WAKEUP, proc->pid, (proc->rq != NULL) ? proc->rq->cpu->id : this_cpu()->id);
         }
         else
         {
@@ -80,23 +362,132 @@ void wakeup_proc(struct proc_struct *proc)
 void schedule(void)
 {
     bool intr_flag;
-    struct proc_struct *next;
     local_intr_save(intr_flag);
     {
-        g_cur_proc->need_resched = 0;
-        if (g_cur_proc->state == PROC_RUNNABLE)
+        // 关了中断就不会换CPU，当前CPU和进程只用取一次
+        struct cpu *cpu = this_cpu();
+        struct proc_struct *cur = cpu->cur_proc, *next;
+        cur->need_resched = 0;
+        if (cur->state == PROC_RUNNABLE)
+        {
+            sched_class_enqueue(cur);
+        }
+        next = sched_class_pick_next(cpu->rq);
+        // 自己的队列空了，去别的CPU那里偷一个
+        if (next == NULL && g_ncpu > 1 && sched_balance(cpu->rq, 1) != 0)
         {
-            sched_class_enqueue(g_cur_proc);
+            next = sched_class_pick_next(cpu->rq);
         }
-        if ((next = sched_class_pick_next()) != NULL)
+        if (next != NULL)
         {
             sched_class_dequeue(next);
         }
+        else
+        {
+            next = cpu->idle_proc;
+        }
         next->runs++;
-        if (next != g_cur_proc)
+        sched_trace(SCHED_EV_SWITCH, cur->pid, next->pid);
+        if (next != cur)
         {
-            proc_run(next);
+            // 还能运行却被换下去的算被抢占，睡眠、等待、退出的算主动让出
+            if (cur->state == PROC_RUNNABLE)
+            {
+                cur->nivcsw++;
+            }
+            else
+            {
+                cur->nvcsw++;
+            }
+            // 已经关了中断，直接切换，不再经过proc_run
+            __proc_run(next);
         }
     }
     local_intr_restore(intr_flag);
 }
+
+// 平均每次操作的周期数
+static uint32_t sched_bench_avg(uint64_t cycles, uint32_t n)
+{
+    do_div(cycles, n);
+    return cycles;
+}
+
+/* *
+ * sched_bench - measure the run queue operations of every sched_class with
+ * @n runnable processes. The processes are fake ones on a private run queue;
+ * each round picks the next process, dequeues it and enqueues it again like
+ * schedule() does. Results are in tsc cycles per operation.
+ * */
+int sched_bench(int n)
+{
+    struct proc_struct *procs;
+    if (n <= 0 || (procs = kmalloc(n * sizeof(struct proc_struct))) == NULL)
+    {
+        return -E_NO_MEM;
+    }
+
+    bool intr_flag;
+    local_intr_save(intr_flag);
+    for (int c = 0; c < NSCHED_CLASSES; c++)
+    {
+        struct sched_class *sched_class = sched_classes[c];
+        struct run_queue rq;
+        rq.max_time_slice = MAX_TIME_SLICE;
+        sched_class->init(&rq);
+
+        srand(n);
+        for (int i = 0; i < n; i++)
+        {
+            struct proc_struct *proc = procs + i;
+            memset(proc, 0, sizeof(struct proc_struct));
+            proc->state = PROC_RUNNABLE;
+            list_init(&(proc->run_link));
+            skew_heap_init(&(proc->run_pool));
+            proc->stride = rand();
+            proc->priority = 1 + i % 8;
+            proc->mlfq_level = i % MLFQ_NLEVELS;
+            proc->vruntime = rand() % (n * CFS_MIN_GRANULARITY);
+        }
+
+        uint64_t start = rdtsc();
+        for (int i = 0; i < n; i++)
+        {
+            sched_class->enqueue(&rq, procs + i);
+        }
+        uint32_t fill = sched_bench_avg(rdtsc() - start, n);
+
+        uint64_t pick = 0, dequeue = 0, enqueue = 0;
+        uint32_t pick_max = 0;
+        for (int i = 0; i < n; i++)
+        {
+            uint64_t t0 = rdtsc();
+            struct proc_struct *next = sched_class->pick_next(&rq);
+            uint64_t t1 = rdtsc();
+            sched_class->dequeue(&rq, next);
+            uint64_t t2 = rdtsc();
+            sched_class->enqueue(&rq, next);
+            uint64_t t3 = rdtsc();
+            pick += t1 - t0, dequeue += t2 - t1, enqueue += t3 - t2;
+            if (t1 - t0 > pick_max)
+            {
+                pick_max = t1 - t0;
+            }
+        }
+
+        struct proc_struct *next;
+        while ((next = sched_class->pick_next(&rq)) != NULL)
+        {
+            sched_class->dequeue(&rq, next);
+        }
+        assert(rq.proc_num == 0);
+
+        cprintf("%-16s n = %d, fill %u, pick_next %u (max %u), dequeue %u, enqueue %u cycles\n",
+                sched_class->name, n, fill, sched_bench_avg(pick, n), pick_max,
+                sched_bench_avg(dequeue, n), sched_bench_avg(enqueue, n));
+    }
+    local_intr_restore(intr_flag);
+
+    kfree(procs);
+    return 0;
+}
@@ -4,9 +4,33 @@
 #include "kern/process/proc.h"
 #include "libs/list.h"
 #include "libs/skew_heap.h"
+#include "libs/rb_tree.h"
+#include "kern/schedule/timer.h"
+#include "kern/driver/clock.h"
 
 #define MAX_TIME_SLICE 5
 
+#define MLFQ_NLEVELS 4       // 多级反馈队列的级数
+#define MLFQ_BOOST_TICKS 100 // 每隔多少tick把所有进程提回最高级
+
+#define CFS_MIN_GRANULARITY 2 // cfs调度器里进程被抢占前至少运行的tick数
+
+#define PRIORITY_MAX 100 // setpriority能设置的最大优先级，最小是1
+
+// 多处理器负载均衡的参数，空闲的CPU不受这些限制，随时可以从别的队列偷进程
+#define SCHED_BALANCE_TICKS 10 // 每个CPU每隔多少tick做一次周期性的负载均衡
+#define SCHED_IMBALANCE 2      // 最忙的CPU比自己多这么多进程才迁移
+#define SCHED_MIGRATION_COST 3 // 在队列里等了不到这么多tick的进程缓存还是热的，不迁移
+#define SCHED_MIGRATE_MAX 8    // 一次最多迁移的进程数
+
+#define NICE_MIN (-20) // 最高的nice值
+#define NICE_MAX 19    // 最低的nice值
+
+// 启动时使用的调度器，可以在make的时候用SCHED=mlfq或者SCHED=cfs选择
+#ifndef SCHED_CLASS
+#define SCHED_CLASS "stride"
+#endif
+
 struct run_queue;
 
 // The introduction of scheduling classes is borrrowed from Linux, and makes the
@@ -26,45 +50,38 @@ struct sched_class
     struct proc_struct *(*pick_next)(struct run_queue *rq);
     // dealer of the time-tick
     void (*proc_tick)(struct run_queue *rq, struct proc_struct *proc);
-    /* for SMP support in the future
-     *  load_balance
-     *     void (*load_balance)(struct rq* rq);
-     *  get some proc from this rq, used in load_balance,
-     *  return value is the num of gotten proc
-     *  int (*get_proc)(struct rq* rq, struct proc* procs_moved[]);
-     */
+    // take at most n procs which may move to dst out of the runqueue (see
+    // sched_can_migrate), used by load balancing. the proc to run next is only
+    // taken if take_next is set. return value is the num of gotten proc
+    int (*get_proc)(struct run_queue *rq, struct run_queue *dst, struct proc_struct *procs_moved[], int n, uint32_t min_wait, bool take_next);
 };
 
-struct proc_struct;
-
-typedef struct
-{
-    unsigned int expires;
-    struct proc_struct *proc;
-    list_entry_t timer_link;
-} timer_t;
-
-#define le2timer(le, member) \
-    to_struct((le), timer_t, member)
-
-static inline timer_t *timer_init(timer_t *timer, struct proc_struct *proc, int expires)
-{
-    timer->expires = expires;
-    timer->proc = proc;
-    list_init(&(timer->timer_link));
-    return timer;
-}
-
 struct run_queue
 {
+    struct cpu *cpu; // 运行队列所属的CPU
     unsigned int proc_num;
     int max_time_slice;
-    skew_heap_entry_t *run_pool;
+    skew_heap_entry_t *run_pool;               // stride调度器的斜堆
+    list_entry_t mlfq_queues[MLFQ_NLEVELS];    // 多级反馈队列调度器每一级的队列
+    unsigned int mlfq_boost_ticks;             // 距离上次把所有进程提回最高级的tick数
+    rb_tree_t cfs_tree;                        // cfs调度器按vruntime排序的红黑树
+    uint32_t cfs_min_vruntime;                 // cfs调度器里最小的vruntime，只增不减
+    rb_tree_t edf_tree;                        // edf调度器按截止时间排序的红黑树
+    unsigned int balance_ticks;                // 距离上次周期性负载均衡的tick数
 };
 
+// 进程能否从队列里迁移到dst：dst的CPU在它的亲和性掩码里，并且等了至少min_wait个tick
+#define sched_can_migrate(proc, dst, min_wait) \
+    (((proc)->cpus_allowed & cpu_mask((dst)->cpu)) && g_ticks - (proc)->wait_start >= (min_wait))
+
 void sched_init(void);
 
 void schedule(void);
 void wakeup_proc(struct proc_struct *proc);
+void run_timer_list(bool in_user);
+void sched_idle(void);
+int sched_bench(int n);
+int sched_set_affinity(struct proc_struct *proc, uint32_t mask);
+void sched_requeue(struct proc_struct *proc);
 
 #endif // __KERN_SCHEDULE_SCHED_H__
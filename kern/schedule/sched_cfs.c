@@ -0,0 +1,188 @@
+#include "kern/schedule/sched_cfs.h"
+#include "kern/process/proc.h"
+#include "kern/debug/assert.h"
+#include "libs/defs.h"
+#include "libs/rb_tree.h"
+
+/* *
+ * 完全公平调度（CFS）
+ *
+ * 每个进程记录一个虚拟运行时间vruntime，运行一个tick增加的量和进程的权重
+ * 成反比，nice值越小权重越大，vruntime涨得越慢。运行队列是按vruntime排序
+ * 的红黑树，每次选vruntime最小的进程运行。一个进程至少运行
+ * CFS_MIN_GRANULARITY个tick才会被vruntime更小的进程抢占，避免切换太频繁。
+ * */
+
+#define NICE_0_WEIGHT 1024
+#define CFS_TICK_VRUNTIME 1024 // nice为0的进程运行一个tick增加的vruntime
+
+// 睡眠醒来的进程vruntime最多比min_vruntime落后这么多，不能靠睡眠攒下太多运行时间
+#define CFS_SLEEPER_CREDIT (CFS_MIN_GRANULARITY * CFS_TICK_VRUNTIME)
+
+// nice值-20~19对应的权重，相邻两级的CPU占比差不多差10%（和Linux一样）
+static const uint32_t cfs_nice_to_weight[NICE_MAX - NICE_MIN + 1] = {
+    /* -20 */ 88761, 71755, 56483, 46273, 36291,
+    /* -15 */ 29154, 23254, 18705, 14949, 11916,
+    /* -10 */ 9548, 7620, 6100, 4904, 3906,
+    /*  -5 */ 3121, 2501, 1991, 1586, 1277,
+    /*   0 */ 1024, 820, 655, 526, 423,
+    /*   5 */ 335, 272, 215, 172, 137,
+    /*  10 */ 110, 87, 70, 56, 45,
+    /*  15 */ 36, 29, 23, 18, 15,
+};
+
+/* *
+ * cfs_priority_to_nice - the nice value whose weight is closest to @priority
+ * times that of nice 0, so that setpriority gives about the same CPU shares
+ * as under the stride scheduler. Priority 1 is nice 0.
+ * */
+int cfs_priority_to_nice(uint32_t priority)
+{
+    uint32_t weight = priority * NICE_0_WEIGHT;
+    int nice = 0;
+    // 权重随nice减小而增大，找到第一个不小于weight的，再和前一个比哪个更近
+    while (nice > NICE_MIN && cfs_nice_to_weight[nice - NICE_MIN] < weight)
+    {
+        nice--;
+    }
+    if (nice < 0 && cfs_nice_to_weight[nice - NICE_MIN] >= weight &&
+        cfs_nice_to_weight[nice - NICE_MIN] - weight > weight - cfs_nice_to_weight[nice + 1 - NICE_MIN])
+    {
+        nice++;
+    }
+    return nice;
+}
+
+#define cfs_vruntime(node) (le2proc((node), cfs_node)->vruntime)
+
+static int cfs_comp(rb_node_t *a, rb_node_t *b)
+{
+    int32_t c = cfs_vruntime(a) - cfs_vruntime(b);
+    return (c > 0) - (c < 0);
+}
+
+// min_vruntime只增不减，跟着队列里和正在运行的最小的vruntime走
+static void cfs_update_min_vruntime(struct run_queue *rq, struct proc_struct *cur)
+{
+    rb_node_t *first = rb_first(&(rq->cfs_tree));
+    uint32_t vruntime;
+    if (first != NULL)
+    {
+        vruntime = cfs_vruntime(first);
+        if (cur != NULL && (int32_t)(cur->vruntime - vruntime) < 0)
+        {
+            vruntime = cur->vruntime;
+        }
+    }
+    else if (cur != NULL)
+    {
+        vruntime = cur->vruntime;
+    }
+    else
+    {
+        return;
+    }
+    if ((int32_t)(vruntime - rq->cfs_min_vruntime) > 0)
+    {
+        rq->cfs_min_vruntime = vruntime;
+    }
+}
+
+static void cfs_init(struct run_queue *rq)
+{
+    rb_tree_init(&(rq->cfs_tree), cfs_comp);
+    rq->cfs_min_vruntime = 0;
+    rq->proc_num = 0;
+}
+
+static void cfs_enqueue(struct run_queue *rq, struct proc_struct *proc)
+{
+    // 从别的队列迁移过来的，vruntime换算成相对这个队列的min_vruntime的值
+    if (proc->rq != NULL && proc->rq != rq)
+    {
+        proc->vruntime += rq->cfs_min_vruntime - proc->rq->cfs_min_vruntime;
+    }
+    if (proc != g_cur_proc)
+    {
+        // 新建或者刚被唤醒的进程，从min_vruntime附近开始
+        uint32_t min = rq->cfs_min_vruntime - CFS_SLEEPER_CREDIT;
+        if ((int32_t)(proc->vruntime - min) < 0)
+        {
+            proc->vruntime = min;
+        }
+        // 比rq所在CPU上运行的进程落后超过一个最小粒度就抢占它
+        struct proc_struct *cur = rq->cpu->cur_proc;
+        if (cur != rq->cpu->idle_proc && cur->rq == rq &&
+            (int32_t)(cur->vruntime - proc->vruntime) > CFS_SLEEPER_CREDIT)
+        {
+            cur->need_resched = 1;
+        }
+    }
+    // time_slice记录这次被选中后运行了多少个tick
+    proc->time_slice = 0;
+    rb_insert(&(rq->cfs_tree), &(proc->cfs_node));
+    proc->rq = rq;
+    rq->proc_num++;
+}
+
+static void cfs_dequeue(struct run_queue *rq, struct proc_struct *proc)
+{
+    assert(proc->rq == rq && rq->proc_num > 0);
+    rb_delete(&(rq->cfs_tree), &(proc->cfs_node));
+    rq->proc_num--;
+    cfs_update_min_vruntime(rq, NULL);
+}
+
+static struct proc_struct *cfs_pick_next(struct run_queue *rq)
+{
+    rb_node_t *first = rb_first(&(rq->cfs_tree));
+    return (first != NULL) ? le2proc(first, cfs_node) : NULL;
+}
+
+static void cfs_proc_tick(struct run_queue *rq, struct proc_struct *proc)
+{
+    assert(proc->nice >= NICE_MIN && proc->nice <= NICE_MAX);
+    proc->vruntime += CFS_TICK_VRUNTIME * NICE_0_WEIGHT / cfs_nice_to_weight[proc->nice - NICE_MIN];
+    proc->time_slice++;
+    cfs_update_min_vruntime(rq, proc);
+
+    rb_node_t *first = rb_first(&(rq->cfs_tree));
+    if (proc->time_slice >= CFS_MIN_GRANULARITY && first != NULL &&
+        (int32_t)(cfs_vruntime(first) - proc->vruntime) < 0)
+    {
+        proc->need_resched = 1;
+    }
+}
+
+// 按vruntime从小到大找，除非take_next，否则跳过vruntime最小、马上要运行的那个进程
+static int cfs_get_proc(struct run_queue *rq, struct run_queue *dst, struct proc_struct *procs_moved[], int n, uint32_t min_wait, bool take_next)
+{
+    int cnt = 0;
+    rb_node_t *node = rb_first(&(rq->cfs_tree));
+    if (node != NULL && !take_next)
+    {
+        node = rb_next(node);
+    }
+    for (; node != NULL && cnt < n; node = rb_next(node))
+    {
+        if (sched_can_migrate(le2proc(node, cfs_node), dst, min_wait))
+        {
+            procs_moved[cnt++] = le2proc(node, cfs_node);
+        }
+    }
+    for (int i = 0; i < cnt; i++)
+    {
+        cfs_dequeue(rq, procs_moved[i]);
+    }
+    return cnt;
+}
+
+struct sched_class g_cfs_sched_class = {
+    .name = "cfs_scheduler",
+    .init = cfs_init,
+    .enqueue = cfs_enqueue,
+    .dequeue = cfs_dequeue,
+    .pick_next = cfs_pick_next,
+    .proc_tick = cfs_proc_tick,
+    .get_proc = cfs_get_proc,
+};
@@ -0,0 +1,10 @@
+#ifndef __KERN_SCHEDULE_SCHED_CFS_H__
+#define __KERN_SCHEDULE_SCHED_CFS_H__
+
+#include "kern/schedule/sched.h"
+
+extern struct sched_class g_cfs_sched_class;
+
+int cfs_priority_to_nice(uint32_t priority);
+
+#endif // __KERN_SCHEDULE_SCHED_CFS_H__
@@ -0,0 +1,171 @@
+#include "kern/schedule/sched_edf.h"
+#include "kern/process/proc.h"
+#include "kern/sync/sync.h"
+#include "kern/debug/assert.h"
+#include "kern/driver/clock.h"
+#include "libs/defs.h"
+#include "libs/rb_tree.h"
+#include "libs/error.h"
+
+/* *
+ * 实时调度，最早截止时间优先（EDF）
+ *
+ * 实时进程每dl_period个tick是一个周期，每个周期最多运行dl_runtime个tick，
+ * 并且要在周期开始后dl_deadline个tick内完成。运行队列按绝对截止时间排序，
+ * 总是先运行截止时间最早的进程。一个周期的运行时间用完后进程被挂起，直到
+ * 下个周期开始才补充运行时间，所以实时进程最多只能占用它申请的那部分CPU。
+ * 所有实时进程的CPU占用率之和不能超过EDF_MAX_UTIL，超过的申请会被拒绝。
+ * */
+
+#define EDF_UTIL_SHIFT 10
+#define EDF_MAX_UTIL ((1 << EDF_UTIL_SHIFT) * 9 / 10) // 给普通进程至少留10%的CPU
+
+#define edf_util(runtime, period) (((runtime) << EDF_UTIL_SHIFT) / (period))
+
+static uint32_t edf_total_util; // 所有实时进程的CPU占用率之和
+
+#define edf_deadline(node) (le2proc((node), dl_node)->dl_abs_deadline)
+
+static int edf_comp(rb_node_t *a, rb_node_t *b)
+{
+    int32_t c = edf_deadline(a) - edf_deadline(b);
+    return (c > 0) - (c < 0);
+}
+
+// 开始一个新的周期
+static void edf_new_period(struct proc_struct *proc, uint32_t start)
+{
+    proc->dl_abs_deadline = start + proc->dl_deadline;
+    proc->dl_remaining = proc->dl_runtime;
+    proc->dl_throttled = 0;
+}
+
+static void edf_init(struct run_queue *rq)
+{
+    rb_tree_init(&(rq->edf_tree), edf_comp);
+    rq->proc_num = 0;
+}
+
+static void edf_replenish(timer_t *timer);
+
+static void edf_enqueue(struct run_queue *rq, struct proc_struct *proc)
+{
+    uint32_t now = g_ticks;
+    proc->rq = rq;
+    // 新建或者刚醒来的进程，如果上个周期的截止时间已经过了就从现在开始一个新周期
+    if (proc != g_cur_proc && (int32_t)(now - proc->dl_abs_deadline) >= 0)
+    {
+        edf_new_period(proc, now);
+    }
+    if (proc->dl_throttled)
+    {
+        // 运行时间用完了，等到下个周期开始再进队列
+        if (list_empty(&(proc->dl_timer.timer_link)))
+        {
+            uint32_t next = proc->dl_abs_deadline - proc->dl_deadline + proc->dl_period;
+            int32_t delta = next - now;
+            timer_init(&(proc->dl_timer), proc, (delta > 0) ? delta : 1);
+            proc->dl_timer.func = edf_replenish;
+            add_timer(&(proc->dl_timer));
+        }
+        return;
+    }
+    rb_insert(&(rq->edf_tree), &(proc->dl_node));
+    rq->proc_num++;
+
+    // 实时进程总是抢占普通进程，实时进程之间截止时间早的抢占晚的，比较的是rq所在CPU上运行的进程
+    struct proc_struct *cur = rq->cpu->cur_proc;
+    if (proc != cur && (cur->dl_period == 0 ||
+                        (int32_t)(proc->dl_abs_deadline - cur->dl_abs_deadline) < 0))
+    {
+        cur->need_resched = 1;
+    }
+}
+
+static void edf_dequeue(struct run_queue *rq, struct proc_struct *proc)
+{
+    assert(proc->rq == rq && rq->proc_num > 0);
+    rb_delete(&(rq->edf_tree), &(proc->dl_node));
+    rq->proc_num--;
+}
+
+static struct proc_struct *edf_pick_next(struct run_queue *rq)
+{
+    rb_node_t *first = rb_first(&(rq->edf_tree));
+    return (first != NULL) ? le2proc(first, dl_node) : NULL;
+}
+
+static void edf_proc_tick(struct run_queue *rq, struct proc_struct *proc)
+{
+    if (--proc->dl_remaining <= 0)
+    {
+        proc->dl_throttled = 1;
+        proc->need_resched = 1;
+    }
+}
+
+// 下个周期开始了，补充运行时间，在时钟中断里调用
+static void edf_replenish(timer_t *timer)
+{
+    struct proc_struct *proc = timer->proc;
+    edf_new_period(proc, g_ticks);
+    if (proc->state == PROC_RUNNABLE && proc != g_cur_proc)
+    {
+        // 挂起期间亲和性掩码可能变了，重新选队列
+        sched_requeue(proc);
+    }
+}
+
+/* *
+ * edf_set_params - make @proc a real-time process, or a normal one again if
+ * @period is 0. @proc must not be in any run queue, i.e. it's the current
+ * process or it's exiting.
+ * @runtime:    ticks to run in each period
+ * @deadline:   ticks from the start of a period to its deadline
+ * @period:     ticks of a period
+ *
+ * Returns -E_INVAL if not 0 < @runtime <= @deadline <= @period, or -E_BUSY
+ * if the total utilization of real-time processes would exceed EDF_MAX_UTIL.
+ * */
+int edf_set_params(struct proc_struct *proc, uint32_t runtime, uint32_t deadline, uint32_t period)
+{
+    if (period != 0 && !(0 < runtime && runtime <= deadline && deadline <= period))
+    {
+        return -E_INVAL;
+    }
+
+    int ret = 0;
+    bool intr_flag;
+    local_intr_save(intr_flag);
+    {
+        uint32_t old_util = (proc->dl_period != 0) ? edf_util(proc->dl_runtime, proc->dl_period) : 0;
+        uint32_t new_util = (period != 0) ? edf_util(runtime, period) : 0;
+        if (edf_total_util - old_util + new_util > EDF_MAX_UTIL)
+        {
+            ret = -E_BUSY;
+            goto out;
+        }
+        edf_total_util = edf_total_util - old_util + new_util;
+
+        del_timer(&(proc->dl_timer));
+        proc->dl_runtime = runtime;
+        proc->dl_deadline = deadline;
+        proc->dl_period = period;
+        if (period != 0)
+        {
+            edf_new_period(proc, g_ticks);
+        }
+    }
+out:
+    local_intr_restore(intr_flag);
+    return ret;
+}
+
+struct sched_class g_edf_sched_class = {
+    .name = "edf_scheduler",
+    .init = edf_init,
+    .enqueue = edf_enqueue,
+    .dequeue = edf_dequeue,
+    .pick_next = edf_pick_next,
+    .proc_tick = edf_proc_tick,
+};
@@ -0,0 +1,10 @@
+#ifndef __KERN_SCHEDULE_SCHED_EDF_H__
+#define __KERN_SCHEDULE_SCHED_EDF_H__
+
+#include "kern/schedule/sched.h"
+
+extern struct sched_class g_edf_sched_class;
+
+int edf_set_params(struct proc_struct *proc, uint32_t runtime, uint32_t deadline, uint32_t period);
+
+#endif // __KERN_SCHEDULE_SCHED_EDF_H__
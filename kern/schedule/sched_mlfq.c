@@ -0,0 +1,169 @@
+#include "kern/schedule/sched_mlfq.h"
+#include "kern/process/proc.h"
+#include "kern/debug/assert.h"
+#include "libs/defs.h"
+#include "libs/list.h"
+
+/* *
+ * 多级反馈队列调度
+ *
+ * 0级优先级最高，时间片最短。进程用完一个时间片就降一级，睡眠后被唤醒时
+ * 升一级，这样等待io的交互式进程会留在高优先级，计算密集的进程沉到底层。
+ * 每隔MLFQ_BOOST_TICKS把所有进程提回0级，防止底层的进程饿死。
+ * setpriority设置的优先级决定进程最多能降到哪一级。
+ * */
+
+// 第level级的时间片，每降一级翻倍
+#define mlfq_time_slice(level) (1 << (level))
+
+// 进程最多能降到的级别，优先级1可以降到最底层，优先级每翻一倍少降一级
+static int mlfq_lowest_level(struct proc_struct *proc)
+{
+    int level = MLFQ_NLEVELS - 1;
+    for (uint32_t priority = proc->priority; priority > 1 && level > 0; priority >>= 1)
+    {
+        level--;
+    }
+    return level;
+}
+
+static void mlfq_init(struct run_queue *rq)
+{
+    for (int i = 0; i < MLFQ_NLEVELS; i++)
+    {
+        list_init(rq->mlfq_queues + i);
+    }
+    rq->mlfq_boost_ticks = 0;
+    rq->proc_num = 0;
+}
+
+static void mlfq_enqueue(struct run_queue *rq, struct proc_struct *proc)
+{
+    if (proc->rq != NULL && proc->rq != rq)
+    {
+        // 从别的队列迁移过来的，保持原来的级别和时间片
+    }
+    else if (proc != g_cur_proc)
+    {
+        // 新建或者刚被唤醒的进程升一级，并且比rq所在CPU上运行的进程优先级高的话抢占它
+        if (proc->mlfq_level > 0)
+        {
+            proc->mlfq_level--;
+        }
+        proc->time_slice = mlfq_time_slice(proc->mlfq_level);
+        struct proc_struct *cur = rq->cpu->cur_proc;
+        if (cur != rq->cpu->idle_proc && proc->mlfq_level < cur->mlfq_level)
+        {
+            cur->need_resched = 1;
+        }
+    }
+    else if (proc->time_slice == 0)
+    {
+        // 用完了时间片，降一级，优先级刚被调高的直接回到能降到的最低一级
+        int lowest = mlfq_lowest_level(proc);
+        if (proc->mlfq_level < lowest)
+        {
+            proc->mlfq_level++;
+        }
+        else
+        {
+            proc->mlfq_level = lowest;
+        }
+        proc->time_slice = mlfq_time_slice(proc->mlfq_level);
+    }
+    // 主动让出CPU的进程留在原来的级别，剩下的时间片也不重置
+    list_add_before(rq->mlfq_queues + proc->mlfq_level, &(proc->run_link));
+    proc->rq = rq;
+    rq->proc_num++;
+}
+
+static void mlfq_dequeue(struct run_queue *rq, struct proc_struct *proc)
+{
+    assert(!list_empty(&(proc->run_link)) && proc->rq == rq);
+    list_del_init(&(proc->run_link));
+    rq->proc_num--;
+}
+
+static struct proc_struct *mlfq_pick_next(struct run_queue *rq)
+{
+    for (int i = 0; i < MLFQ_NLEVELS; i++)
+    {
+        list_entry_t *le = list_next(rq->mlfq_queues + i);
+        if (le != rq->mlfq_queues + i)
+        {
+            return le2proc(le, run_link);
+        }
+    }
+    return NULL;
+}
+
+// 把所有进程提回0级
+static void mlfq_boost(struct run_queue *rq, struct proc_struct *proc)
+{
+    for (int i = 1; i < MLFQ_NLEVELS; i++)
+    {
+        list_entry_t *le;
+        while ((le = list_next(rq->mlfq_queues + i)) != rq->mlfq_queues + i)
+        {
+            struct proc_struct *p = le2proc(le, run_link);
+            list_del(le);
+            list_add_before(rq->mlfq_queues, le);
+            p->mlfq_level = 0;
+            p->time_slice = mlfq_time_slice(0);
+        }
+    }
+    if (proc->mlfq_level != 0)
+    {
+        proc->mlfq_level = 0;
+        proc->time_slice = mlfq_time_slice(0);
+        proc->need_resched = 1;
+    }
+}
+
+static void mlfq_proc_tick(struct run_queue *rq, struct proc_struct *proc)
+{
+    if (proc->time_slice > 0)
+    {
+        proc->time_slice--;
+    }
+    if (proc->time_slice == 0)
+    {
+        proc->need_resched = 1;
+    }
+    if (++rq->mlfq_boost_ticks >= MLFQ_BOOST_TICKS)
+    {
+        rq->mlfq_boost_ticks = 0;
+        mlfq_boost(rq, proc);
+    }
+}
+
+// 从最低一级的队尾开始找，这些进程最晚才会运行
+static int mlfq_get_proc(struct run_queue *rq, struct run_queue *dst, struct proc_struct *procs_moved[], int n, uint32_t min_wait, bool take_next)
+{
+    int cnt = 0;
+    for (int i = MLFQ_NLEVELS - 1; i >= 0 && cnt < n; i--)
+    {
+        list_entry_t *le = list_prev(rq->mlfq_queues + i);
+        while (le != rq->mlfq_queues + i && cnt < n)
+        {
+            struct proc_struct *proc = le2proc(le, run_link);
+            le = list_prev(le);
+            if (sched_can_migrate(proc, dst, min_wait))
+            {
+                mlfq_dequeue(rq, proc);
+                procs_moved[cnt++] = proc;
+            }
+        }
+    }
+    return cnt;
+}
+
+struct sched_class g_mlfq_sched_class = {
+    .name = "mlfq_scheduler",
+    .init = mlfq_init,
+    .enqueue = mlfq_enqueue,
+    .dequeue = mlfq_dequeue,
+    .pick_next = mlfq_pick_next,
+    .proc_tick = mlfq_proc_tick,
+    .get_proc = mlfq_get_proc,
+};
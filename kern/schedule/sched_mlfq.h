@@ -0,0 +1,8 @@
+#ifndef __KERN_SCHEDULE_SCHED_MLFQ_H__
+#define __KERN_SCHEDULE_SCHED_MLFQ_H__
+
+#include "kern/schedule/sched.h"
+
+extern struct sched_class g_mlfq_sched_class;
+
+#endif // __KERN_SCHEDULE_SCHED_MLFQ_H__
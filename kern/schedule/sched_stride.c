@@ -24,6 +24,23 @@ proc_stride_comp_f(void *a, void *b)
           return -1;
 }
 
+// 队列的基准stride：堆里最小的，堆空的时候用CPU上正在运行的普通进程的，都没有返回0
+static inline bool stride_base(struct run_queue *rq, uint32_t *base)
+{
+     struct proc_struct *cur = rq->cpu->cur_proc;
+     if (rq->run_pool != NULL)
+     {
+          *base = le2proc(rq->run_pool, run_pool)->stride;
+          return 1;
+     }
+     if (cur != rq->cpu->idle_proc && cur->dl_period == 0)
+     {
+          *base = cur->stride;
+          return 1;
+     }
+     return 0;
+}
+
 static void stride_init(struct run_queue *rq)
 {
      rq->run_pool = NULL;
@@ -33,6 +50,12 @@ static void stride_init(struct run_queue *rq)
 // 添加一个待执行的进程到队列
 static void stride_enqueue(struct run_queue *rq, struct proc_struct *proc)
 {
+     // 从别的队列迁移过来的，保持领先原队列基准的量，两边有一边没有基准就不换算
+     uint32_t src_base, dst_base;
+     if (proc->rq != NULL && proc->rq != rq && stride_base(proc->rq, &src_base) && stride_base(rq, &dst_base))
+     {
+          proc->stride = dst_base + (proc->stride - src_base);
+     }
      rq->run_pool = skew_heap_insert(rq->run_pool, &(proc->run_pool), proc_stride_comp_f);
      if (proc->time_slice == 0 || proc->time_slice > rq->max_time_slice)
      {
@@ -104,6 +127,47 @@ stride_proc_tick(struct run_queue *rq, struct proc_struct *proc)
      }
 }
 
+// 按深度优先找出node下面能迁移到dst的进程
+static int stride_collect(skew_heap_entry_t *node, struct run_queue *dst, struct proc_struct *procs[], int n, uint32_t min_wait)
+{
+     if (node == NULL || n == 0)
+     {
+          return 0;
+     }
+     int cnt = stride_collect(node->left, dst, procs, n, min_wait);
+     cnt += stride_collect(node->right, dst, procs + cnt, n - cnt, min_wait);
+     struct proc_struct *proc = le2proc(node, run_pool);
+     if (cnt < n && sched_can_migrate(proc, dst, min_wait))
+     {
+          procs[cnt++] = proc;
+     }
+     return cnt;
+}
+
+static int stride_get_proc(struct run_queue *rq, struct run_queue *dst, struct proc_struct *procs_moved[], int n, uint32_t min_wait, bool take_next)
+{
+     // 斜堆的根是下一个要运行的进程，除非take_next，否则不迁移它
+     if (rq->run_pool == NULL)
+     {
+          return 0;
+     }
+     int cnt;
+     if (take_next)
+     {
+          cnt = stride_collect(rq->run_pool, dst, procs_moved, n, min_wait);
+     }
+     else
+     {
+          cnt = stride_collect(rq->run_pool->left, dst, procs_moved, n, min_wait);
+          cnt += stride_collect(rq->run_pool->right, dst, procs_moved + cnt, n - cnt, min_wait);
+     }
+     for (int i = 0; i < cnt; i++)
+     {
+          stride_dequeue(rq, procs_moved[i]);
+     }
+     return cnt;
+}
+
 struct sched_class g_stride_sched_class = {
     .name = "stride_scheduler",
     .init = stride_init,
@@ -111,4 +175,5 @@ struct sched_class g_stride_sched_class = {
     .dequeue = stride_dequeue,
     .pick_next = stride_pick_next,
     .proc_tick = stride_proc_tick,
+    .get_proc = stride_get_proc,
 };
@@ -0,0 +1,283 @@
+#include "kern/schedule/sched_trace.h"
+#include "kern/schedule/sched.h"
+#include "kern/process/cpu.h"
+#include "kern/driver/clock.h"
+#include "kern/driver/stdio.h"
+#include "libs/x86.h"
+#include "libs/string.h"
+
+#define SCHED_TRACE_MASK (SCHED_TRACE_SIZE - 1)
+
+// 一个CPU的环形缓冲区，head只增不减，head & SCHED_TRACE_MASK是下一个要写的位置
+struct sched_trace_buf
+{
+    volatile uint32_t head;
+    struct sched_event events[SCHED_TRACE_SIZE];
+};
+
+volatile bool g_sched_trace_on = 1;
+static struct sched_trace_buf sched_trace_bufs[NCPU];
+
+void sched_trace_record(int type, int pid, int arg)
+{
+    struct cpu *cpu = this_cpu();
+    struct sched_trace_buf *buf = sched_trace_bufs + cpu->id;
+    uint32_t head = buf->head;
+    struct sched_event *ev = buf->events + (head & SCHED_TRACE_MASK);
+    ev->tsc = rdtsc();
+    ev->type = type;
+    ev->rq_len = (cpu->rq != NULL) ? cpu->rq->proc_num : 0;
+    ev->pid = pid;
+    ev->arg = arg;
+    // 事件写完了才能让读的一方看到
+    __asm__ __volatile__("" ::: "memory");
+    buf->head = head + 1;
+}
+
+void sched_trace_clear(void)
+{
+    for (int i = 0; i < NCPU; i++)
+    {
+        sched_trace_bufs[i].head = 0;
+    }
+}
+
+// 把各个CPU的缓冲区按时间合并起来读
+struct sched_trace_iter
+{
+    uint32_t pos[NCPU];
+    uint32_t end[NCPU];
+};
+
+// 初始化迭代器，返回所有CPU上还保留着的事件总数
+static int sched_trace_iter_init(struct sched_trace_iter *it)
+{
+    int total = 0;
+    for (int i = 0; i < NCPU; i++)
+    {
+        uint32_t head = sched_trace_bufs[i].head;
+        it->end[i] = head;
+        it->pos[i] = (head > SCHED_TRACE_SIZE) ? head - SCHED_TRACE_SIZE : 0;
+        total += it->end[i] - it->pos[i];
+    }
+    return total;
+}
+
+// 取出最早的一个事件，cpu_store里存它所在的CPU，没有了返回NULL
+static struct sched_event *sched_trace_iter_next(struct sched_trace_iter *it, int *cpu_store)
+{
+    struct sched_event *first = NULL;
+    int cpu = 0;
+    for (int i = 0; i < NCPU; i++)
+    {
+        if (it->pos[i] != it->end[i])
+        {
+            struct sched_event *ev = sched_trace_bufs[i].events + (it->pos[i] & SCHED_TRACE_MASK);
+            if (first == NULL || ev->tsc < first->tsc)
+            {
+                first = ev, cpu = i;
+            }
+        }
+    }
+    if (first != NULL)
+    {
+        it->pos[cpu]++;
+        *cpu_store = cpu;
+    }
+    return first;
+}
+
+static const char *sched_event_names[] = {
+    [SCHED_EV_WAKEUP] = "wakeup",
+    [SCHED_EV_SWITCH] = "switch",
+    [SCHED_EV_RUN] = "run",
+};
+
+/* *
+ * sched_trace_dump - print the last @n events of all the CPUs in time order,
+ * with the time relative to the first printed one. Tracing is paused meanwhile
+ * so that the buffers are not overwritten under us.
+ * */
+void sched_trace_dump(int n)
+{
+    bool on = g_sched_trace_on;
+    g_sched_trace_on = 0;
+
+    struct sched_trace_iter it;
+    int total = sched_trace_iter_init(&it), cpu;
+    struct sched_event *ev;
+    uint64_t start = 0;
+    cprintf("%12s %3s %-6s %5s %5s %6s\n", "cycles", "cpu", "event", "pid", "arg", "rq_len");
+    for (int i = 0; (ev = sched_trace_iter_next(&it, &cpu)) != NULL; i++)
+    {
+        if (i < total - n)
+        {
+            continue;
+        }
+        if (start == 0)
+        {
+            start = ev->tsc;
+        }
+        cprintf("%12llu %3d %-6s %5d %5d %6d\n", ev->tsc - start, cpu,
+                sched_event_names[ev->type], ev->pid, ev->arg, ev->rq_len);
+    }
+
+    g_sched_trace_on = on;
+}
+
+#define SCHED_HIST_BUCKETS 20 // 按2的幂分桶，最后一个桶放所有更大的
+#define SCHED_HIST_WIDTH 40   // 直方图最长的柱子的宽度
+
+struct sched_hist
+{
+    uint32_t count[SCHED_HIST_BUCKETS];
+    uint32_t n;
+    uint64_t sum;
+    uint64_t max;
+};
+
+static void sched_hist_add(struct sched_hist *hist, uint64_t value)
+{
+    int b = 0;
+    while (b < SCHED_HIST_BUCKETS - 1 && value >= (1ULL << b))
+    {
+        b++;
+    }
+    hist->count[b]++;
+    hist->n++;
+    hist->sum += value;
+    if (value > hist->max)
+    {
+        hist->max = value;
+    }
+}
+
+static void sched_hist_print(const char *name, struct sched_hist *hist, const char *unit)
+{
+    if (hist->n == 0)
+    {
+        cprintf("%s: no samples\n", name);
+        return;
+    }
+    uint64_t avg = hist->sum;
+    do_div(avg, hist->n);
+    cprintf("%s: %d samples, avg %llu %s, max %llu %s\n", name, hist->n, avg, unit, hist->max, unit);
+
+    uint32_t most = 0;
+    for (int b = 0; b < SCHED_HIST_BUCKETS; b++)
+    {
+        if (hist->count[b] > most)
+        {
+            most = hist->count[b];
+        }
+    }
+    for (int b = 0; b < SCHED_HIST_BUCKETS; b++)
+    {
+        if (hist->count[b] == 0)
+        {
+            continue;
+        }
+        // 第b个桶是[2^(b-1), 2^b)
+        uint32_t lo = (b == 0) ? 0 : 1 << (b - 1);
+        cprintf("  >= %7u %s %6u |", lo, unit, hist->count[b]);
+        for (int i = hist->count[b] * SCHED_HIST_WIDTH / most; i > 0; i--)
+        {
+            cputchar('#');
+        }
+        cputchar('\n');
+    }
+}
+
+#define SCHED_WAKE_HASH 64 // 记录还没运行的被唤醒进程的哈希表大小
+
+/* *
+ * sched_trace_hist - go through the recorded events in time order and print
+ * the distributions of the wakeup latency (from wakeup_proc to proc_run of
+ * the same process), of the time slices (from proc_run to the next proc_run on
+ * the same CPU, the idle process excluded) and of the run queue lengths.
+ * Times are in microseconds, or in tsc cycles if the tsc isn't calibrated.
+ * */
+void sched_trace_hist(void)
+{
+    bool on = g_sched_trace_on;
+    g_sched_trace_on = 0;
+
+    static struct sched_hist wakeup, slice;
+    static struct
+    {
+        int pid;
+        uint64_t tsc;
+    } waking[SCHED_WAKE_HASH];
+    static struct
+    {
+        int pid;
+        uint64_t tsc;
+    } running[NCPU];
+    static uint32_t rq_len_sum[NCPU], rq_len_max[NCPU], n_events[NCPU];
+    memset(&wakeup, 0, sizeof(wakeup));
+    memset(&slice, 0, sizeof(slice));
+    memset(waking, 0, sizeof(waking));
+    memset(running, 0, sizeof(running));
+    memset(rq_len_sum, 0, sizeof(rq_len_sum));
+    memset(rq_len_max, 0, sizeof(rq_len_max));
+    memset(n_events, 0, sizeof(n_events));
+
+    uint32_t cycles_per_us = clock_tsc_per_tick() / (1000000 / TICK_HZ);
+    const char *unit = (cycles_per_us != 0) ? "us" : "cycles";
+    if (cycles_per_us == 0)
+    {
+        cycles_per_us = 1;
+    }
+
+    struct sched_trace_iter it;
+    sched_trace_iter_init(&it);
+    struct sched_event *ev;
+    int cpu;
+    while ((ev = sched_trace_iter_next(&it, &cpu)) != NULL)
+    {
+        rq_len_sum[cpu] += ev->rq_len;
+        if (ev->rq_len > rq_len_max[cpu])
+        {
+            rq_len_max[cpu] = ev->rq_len;
+        }
+        n_events[cpu]++;
+
+        int h = ev->pid % SCHED_WAKE_HASH;
+        if (ev->type == SCHED_EV_WAKEUP)
+        {
+            waking[h].pid = ev->pid;
+            waking[h].tsc = ev->tsc;
+        }
+        else if (ev->type == SCHED_EV_RUN)
+        {
+            if (waking[h].pid == ev->pid && waking[h].tsc != 0)
+            {
+                uint64_t delta = ev->tsc - waking[h].tsc;
+                do_div(delta, cycles_per_us);
+                sched_hist_add(&wakeup, delta);
+                waking[h].tsc = 0;
+            }
+            if (running[cpu].pid != 0 && running[cpu].tsc != 0)
+            {
+                uint64_t delta = ev->tsc - running[cpu].tsc;
+                do_div(delta, cycles_per_us);
+                sched_hist_add(&slice, delta);
+            }
+            running[cpu].pid = ev->pid;
+            running[cpu].tsc = ev->tsc;
+        }
+    }
+
+    sched_hist_print("wakeup latency", &wakeup, unit);
+    sched_hist_print("time slice", &slice, unit);
+    for (int i = 0; i < NCPU; i++)
+    {
+        if (n_events[i] != 0)
+        {
+            cprintf("cpu%d: %u events, run queue length avg %u.%02u, max %u\n", i, n_events[i],
+                    rq_len_sum[i] / n_events[i], rq_len_sum[i] * 100 / n_events[i] % 100, rq_len_max[i]);
+        }
+    }
+
+    g_sched_trace_on = on;
+}
@@ -0,0 +1,48 @@
+#ifndef __KERN_SCHEDULE_SCHED_TRACE_H__
+#define __KERN_SCHEDULE_SCHED_TRACE_H__
+
+#include "libs/defs.h"
+
+/* *
+ * 调度事件跟踪
+ *
+ * 每个CPU有一个固定大小的环形缓冲区，记录wakeup_proc、schedule和proc_run
+ * 发生的时间（tsc）。只有所属的CPU会在关中断的情况下往里写，所以写的时候
+ * 不用加锁；满了以后覆盖最老的事件。kmonitor的schedtrace命令把各个CPU的
+ * 事件按时间合并后打印出来，schedhist命令统计唤醒延迟和时间片的分布。
+ * */
+
+#define SCHED_TRACE_SIZE 1024 // 每个CPU的缓冲区能放的事件数，必须是2的幂
+
+// 事件类型
+#define SCHED_EV_WAKEUP 1 // 进程被唤醒，arg是放进的运行队列所属的CPU
+#define SCHED_EV_SWITCH 2 // schedule选出了下一个进程，pid是换下的进程，arg是换上的进程
+#define SCHED_EV_RUN 3    // proc_run切换到进程pid
+
+struct sched_event
+{
+    uint64_t tsc;       // 发生的时间
+    uint16_t type;      // 事件类型
+    uint16_t rq_len;    // 当时本CPU运行队列里的进程数
+    int pid;            // 事件对应的进程
+    int arg;            // 和事件类型有关的参数
+};
+
+extern volatile bool g_sched_trace_on;
+
+void sched_trace_record(int type, int pid, int arg);
+
+// 记录一个调度事件，调用时需要关中断
+static inline void sched_trace(int type, int pid, int arg)
+{
+    if (g_sched_trace_on)
+    {
+        sched_trace_record(type, pid, arg);
+    }
+}
+
+void sched_trace_clear(void);
+void sched_trace_dump(int n);
+void sched_trace_hist(void);
+
+#endif // __KERN_SCHEDULE_SCHED_TRACE_H__
@@ -0,0 +1,190 @@
+#include "kern/schedule/timer.h"
+#include "kern/schedule/sched.h"
+#include "kern/process/proc.h"
+#include "kern/sync/sync.h"
+#include "kern/debug/assert.h"
+#include "kern/driver/clock.h"
+
+static struct
+{
+    unsigned int base;                          // 下一个要处理的tick
+    size_t n_timers;                            // 还没到期的定时器个数
+    list_entry_t tv1[TVR_SIZE];                 // 第一层，一个槽一个tick
+    list_entry_t tvn[TV_NLEVELS][TVN_SIZE];     // 后面的各层
+} timer_wheel;
+
+// 第n层（从0开始，不含第一层）里到期时间为expires的槽号
+#define TVN_INDEX(expires, n) (((expires) >> (TVR_BITS + (n)*TVN_BITS)) & TVN_MASK)
+
+void timer_wheel_init(void)
+{
+    timer_wheel.base = g_ticks;
+    for (int i = 0; i < TVR_SIZE; i++)
+    {
+        list_init(timer_wheel.tv1 + i);
+    }
+    for (int n = 0; n < TV_NLEVELS; n++)
+    {
+        for (int i = 0; i < TVN_SIZE; i++)
+        {
+            list_init(timer_wheel.tvn[n] + i);
+        }
+    }
+}
+
+// 按到期时间把timer挂到对应的槽上
+static void timer_wheel_add(timer_t *timer)
+{
+    unsigned int expires = timer->expires;
+    unsigned int idx = expires - timer_wheel.base;
+    list_entry_t *slot;
+    if ((int)idx < 0)
+    {
+        // 已经过期了，放到马上要处理的槽里
+        slot = timer_wheel.tv1 + (timer_wheel.base & TVR_MASK);
+    }
+    else if (idx < TVR_SIZE)
+    {
+        slot = timer_wheel.tv1 + (expires & TVR_MASK);
+    }
+    else
+    {
+        int n = 0;
+        while (n < TV_NLEVELS - 1 && idx >= (1U << (TVR_BITS + (n + 1) * TVN_BITS)))
+        {
+            n++;
+        }
+        slot = timer_wheel.tvn[n] + TVN_INDEX(expires, n);
+    }
+    list_add_before(slot, &(timer->timer_link));
+}
+
+// 把第n层index槽里的定时器重新分散到前面的层里，返回index
+static int timer_wheel_cascade(int n, int index)
+{
+    list_entry_t *slot = timer_wheel.tvn[n] + index, *le;
+    while ((le = list_next(slot)) != slot)
+    {
+        list_del(le);
+        timer_wheel_add(le2timer(le, timer_link));
+    }
+    return index;
+}
+
+/* *
+ * add_timer - start @timer, it expires after @timer->expires ticks and then
+ * wakes up @timer->proc, or calls @timer->func in the timer interrupt. Must
+ * be balanced with del_timer() if the process may be woken up by others
+ * before the timer expires.
+ * */
+void add_timer(timer_t *timer)
+{
+    bool intr_flag;
+    local_intr_save(intr_flag);
+    {
+        assert(timer->expires > 0 && timer->proc != NULL);
+        assert(list_empty(&(timer->timer_link)));
+        timer->expires += g_ticks;
+        timer_wheel_add(timer);
+        timer_wheel.n_timers++;
+    }
+    local_intr_restore(intr_flag);
+}
+
+// 取消timer，已经到期的timer什么也不做
+void del_timer(timer_t *timer)
+{
+    bool intr_flag;
+    local_intr_save(intr_flag);
+    {
+        if (!list_empty(&(timer->timer_link)))
+        {
+            list_del_init(&(timer->timer_link));
+            timer_wheel.n_timers--;
+        }
+    }
+    local_intr_restore(intr_flag);
+}
+
+// 到期处理，唤醒定时器对应的进程
+static void timer_expire(timer_t *timer)
+{
+    struct proc_struct *proc = timer->proc;
+    list_del_init(&(timer->timer_link));
+    timer_wheel.n_timers--;
+    if (timer->func != NULL)
+    {
+        timer->func(timer);
+        return;
+    }
+    if (proc->wait_state != 0)
+    {
+        assert(proc->wait_state & WT_INTERRUPTED);
+    }
+    else
+    {
+        warn("process %d's wait_state == 0.\n", proc->pid);
+    }
+    if (proc->state != PROC_RUNNABLE)
+    {
+        wakeup_proc(proc);
+    }
+    // 让刚醒来的进程尽快有机会运行
+    g_cur_proc->need_resched = 1;
+}
+
+/* *
+ * timer_wheel_run - expire all timers up to tick @now, called with interrupts
+ * disabled from the timer interrupt.
+ * */
+void timer_wheel_run(size_t now)
+{
+    while ((int)(now - timer_wheel.base) >= 0)
+    {
+        int index = timer_wheel.base & TVR_MASK;
+        // 第一层转完一圈，从下一层取一个槽下来，逐层进位
+        if (index == 0)
+        {
+            int n = 0;
+            while (n < TV_NLEVELS && timer_wheel_cascade(n, TVN_INDEX(timer_wheel.base, n)) == 0)
+            {
+                n++;
+            }
+        }
+        timer_wheel.base++;
+
+        list_entry_t *slot = timer_wheel.tv1 + index, *le;
+        while ((le = list_next(slot)) != slot)
+        {
+            timer_expire(le2timer(le, timer_link));
+        }
+    }
+}
+
+/* *
+ * timer_wheel_next - get the number of ticks from now until the next timer
+ * expires into @ticks_store, returns 0 if there is no timer at all. Timers in
+ * the upper levels are reported at the next cascade, which is no later than
+ * their expiry.
+ * */
+bool timer_wheel_next(size_t now, size_t *ticks_store)
+{
+    if (timer_wheel.n_timers == 0)
+    {
+        return 0;
+    }
+    unsigned int expires = timer_wheel.base;
+    if ((int)(now - expires) >= 0)
+    {
+        // 还有没处理的tick，马上就要处理
+        *ticks_store = 0;
+        return 1;
+    }
+    // 找第一层里最近的非空槽，最远找到第一层转完一圈要进位的时候
+    while ((expires & TVR_MASK) != 0 && list_empty(timer_wheel.tv1 + (expires & TVR_MASK)))
+    {
+        expires++;
+    }
+    *ticks_store = expires - now;
+    return 1;
+}
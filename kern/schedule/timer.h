@@ -0,0 +1,52 @@
+#ifndef __KERN_SCHEDULE_TIMER_H__
+#define __KERN_SCHEDULE_TIMER_H__
+
+#include "libs/defs.h"
+#include "libs/list.h"
+
+/* *
+ * 分层时间轮
+ *
+ * 第一层有TVR_SIZE个槽，每个槽对应一个tick；后面每一层有TVN_SIZE个槽，
+ * 每个槽对应前一层转一圈的时间。定时器按到期时间直接挂到对应的槽上，
+ * 第一层每转一圈就把下一层的一个槽里的定时器重新分散到前面的层里。
+ * 插入、删除和每个tick的到期处理都是O(1)的。
+ * */
+
+#define TVN_BITS 6
+#define TVR_BITS 8
+#define TVN_SIZE (1 << TVN_BITS)
+#define TVR_SIZE (1 << TVR_BITS)
+#define TVN_MASK (TVN_SIZE - 1)
+#define TVR_MASK (TVR_SIZE - 1)
+#define TV_NLEVELS 4 // 除第一层以外的层数，8 + 6 * 4 = 32位
+
+struct proc_struct;
+
+typedef struct timer
+{
+    unsigned int expires;              // 调用add_timer前是要等待的tick数，之后是到期的g_ticks
+    struct proc_struct *proc;          // 到期时唤醒的进程
+    void (*func)(struct timer *timer); // 不为NULL时到期调用它，而不是唤醒proc
+    list_entry_t timer_link;           // 挂在时间轮的槽上
+} timer_t;
+
+#define le2timer(le, member) \
+    to_struct((le), timer_t, member)
+
+static inline timer_t *timer_init(timer_t *timer, struct proc_struct *proc, int expires)
+{
+    timer->expires = expires;
+    timer->proc = proc;
+    timer->func = NULL;
+    list_init(&(timer->timer_link));
+    return timer;
+}
+
+void timer_wheel_init(void);
+void add_timer(timer_t *timer);
+void del_timer(timer_t *timer);
+void timer_wheel_run(size_t now);
+bool timer_wheel_next(size_t now, size_t *ticks_store);
+
+#endif /* !__KERN_SCHEDULE_TIMER_H__ */
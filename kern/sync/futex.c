@@ -0,0 +1,134 @@
+#include "kern/sync/futex.h"
+#include "kern/sync/wait.h"
+#include "kern/schedule/sched.h"
+#include "kern/sync/sync.h"
+#include "kern/process/proc.h"
+#include "kern/mm/vmm.h"
+#include "kern/mm/pmm.h"
+#include "kern/mm/mmu.h"
+#include "kern/mm/mem_layout.h"
+#include "libs/stdlib.h"
+#include "libs/error.h"
+
+#define FUTEX_HASH_SHIFT 6
+#define FUTEX_HASH_SIZE (1 << FUTEX_HASH_SHIFT)
+#define futex_hashfn(key) (hash32(key, FUTEX_HASH_SHIFT))
+
+// 不同地址的等待者可能落在同一个桶里，唤醒时要比较key
+struct futex_waiter
+{
+    wait_t wait;
+    uintptr_t key; // futex的物理地址
+};
+
+static wait_queue_t futex_queues[FUTEX_HASH_SIZE];
+
+void futex_init(void)
+{
+    for (int i = 0; i < FUTEX_HASH_SIZE; i++)
+    {
+        wait_queue_init(futex_queues + i);
+    }
+}
+
+// 先访问一次用户地址，不在内存里的页由缺页异常调进来
+static int futex_fault_in(struct mm_struct *mm, uintptr_t uaddr)
+{
+    int value, ret = 0;
+    if (uaddr % sizeof(int) != 0)
+    {
+        return -E_INVAL;
+    }
+    lock_mm(mm);
+    if (!copy_from_user(mm, &value, (void *)uaddr, sizeof(int), 1))
+    {
+        ret = -E_FAULT;
+    }
+    unlock_mm(mm);
+    return ret;
+}
+
+// 用户地址对应的物理地址，调用时需要关中断，页不在内存里返回0
+static uintptr_t futex_key(struct mm_struct *mm, uintptr_t uaddr)
+{
+    pte_t *ptep = get_pte(mm->pgdir, uaddr, 0);
+    if (ptep == NULL || !(*ptep & PTE_P))
+    {
+        return 0;
+    }
+    return PTE_ADDR(*ptep) | PG_OFF(uaddr);
+}
+
+/* *
+ * do_futex_wait - sleep on @uaddr if it still holds @expected. The check and
+ * the sleep are done with interrupts off, so a wake from another process
+ * between them can't be lost. Returns -E_AGAIN if the value has changed,
+ * and 0 once woken up by do_futex_wake.
+ * */
+int do_futex_wait(uintptr_t uaddr, int expected)
+{
+    struct mm_struct *mm = g_cur_proc->mm;
+    int ret;
+    if ((ret = futex_fault_in(mm, uaddr)) != 0)
+    {
+        return ret;
+    }
+
+    bool intr_flag;
+    local_intr_save(intr_flag);
+    uintptr_t key = futex_key(mm, uaddr);
+    // 刚调进来的页又被换出去了，让用户态重新检查一遍
+    if (key == 0 || *(volatile int *)KADDR(key) != expected)
+    {
+        local_intr_restore(intr_flag);
+        return -E_AGAIN;
+    }
+    wait_queue_t *queue = futex_queues + futex_hashfn(key);
+    struct futex_waiter waiter;
+    waiter.key = key;
+    wait_current_set(queue, &(waiter.wait), WT_FUTEX);
+    local_intr_restore(intr_flag);
+
+    schedule();
+
+    local_intr_save(intr_flag);
+    wait_current_del(queue, &(waiter.wait));
+    local_intr_restore(intr_flag);
+
+    if (waiter.wait.wakeup_flags != WT_FUTEX)
+    {
+        return -E_KILLED;
+    }
+    return 0;
+}
+
+// do_futex_wake - wake up at most @n processes sleeping on @uaddr, return how many were woken
+int do_futex_wake(uintptr_t uaddr, int n)
+{
+    struct mm_struct *mm = g_cur_proc->mm;
+    int ret;
+    if ((ret = futex_fault_in(mm, uaddr)) != 0)
+    {
+        return ret;
+    }
+
+    bool intr_flag;
+    local_intr_save(intr_flag);
+    uintptr_t key = futex_key(mm, uaddr);
+    if (key != 0)
+    {
+        wait_queue_t *queue = futex_queues + futex_hashfn(key);
+        wait_t *wait = wait_queue_first(queue), *next;
+        for (; wait != NULL && ret < n; wait = next)
+        {
+            next = wait_queue_next(queue, wait);
+            if (to_struct(wait, struct futex_waiter, wait)->key == key)
+            {
+                wakeup_wait(queue, wait, WT_FUTEX, 1);
+                ret++;
+            }
+        }
+    }
+    local_intr_restore(intr_flag);
+    return ret;
+}
@@ -0,0 +1,19 @@
+#ifndef __KERN_SYNC_FUTEX_H__
+#define __KERN_SYNC_FUTEX_H__
+
+#include "libs/defs.h"
+
+/* *
+ * futex - 用户态锁的等待和唤醒
+ *
+ * 用户态的锁和条件变量在没有竞争时只用原子操作，只有需要睡眠或者唤醒别人
+ * 时才调用futex。等待的进程按用户地址对应的物理地址放进哈希表的等待队列，
+ * 所以同一个进程的线程之间和共享内存的进程之间都能用。
+ * 等待期间futex所在的页不能被换出，换回来以后物理地址变了会收不到唤醒。
+ * */
+
+void futex_init(void);
+int do_futex_wait(uintptr_t uaddr, int expected);
+int do_futex_wake(uintptr_t uaddr, int n);
+
+#endif /* !__KERN_SYNC_FUTEX_H__ */
@@ -6,6 +6,7 @@
 #include "kern/driver/intr.h"
 #include "libs/atomic.h"
 #include "kern/debug/assert.h"
+#include "kern/process/cpu.h"
 
 static inline bool __intr_save(void)
 {
@@ -32,6 +33,69 @@ static inline void __intr_restore(bool flag)
     } while (0)
 #define local_intr_restore(x) __intr_restore(x);
 
+/* *
+ * 自旋锁
+ *
+ * local_intr_save只能挡住本CPU上的中断，多个CPU之间要用自旋锁互斥。持有自旋锁
+ * 的时候不能睡眠，如果中断处理里也会拿这把锁，要先用local_intr_save关中断。
+ * */
+typedef struct
+{
+    volatile uint32_t locked; // 是否被持有
+    struct cpu *cpu;          // 持有锁的CPU
+    const char *name;         // 锁的名字，调试用
+} spinlock_t;
+
+static inline void
+spin_lock_init(spinlock_t *lock, const char *name)
+{
+    lock->locked = 0;
+    lock->cpu = NULL;
+    lock->name = name;
+}
+
+static inline bool
+spin_trylock(spinlock_t *lock)
+{
+    if (xchg(&(lock->locked), 1) != 0)
+    {
+        return 0;
+    }
+    lock->cpu = this_cpu();
+    return 1;
+}
+
+static inline void
+spin_lock(spinlock_t *lock)
+{
+    // 先只读地等到锁看起来空闲再去抢，避免xchg来回抢缓存行
+    while (!spin_trylock(lock))
+    {
+        while (lock->locked)
+        {
+            pause();
+        }
+    }
+}
+
+static inline void
+spin_unlock(spinlock_t *lock)
+{
+    if (lock->cpu != this_cpu())
+    {
+        panic("spin_unlock %s: not held by this cpu.\n", lock->name);
+    }
+    lock->cpu = NULL;
+    xchg(&(lock->locked), 0);
+}
+
+// 当前CPU是否持有锁，调用者需要关中断
+static inline bool
+spin_holding(spinlock_t *lock)
+{
+    return lock->locked && lock->cpu == this_cpu();
+}
+
 typedef volatile bool lock_t;
 
 static inline void
@@ -6,10 +6,23 @@
 #include "kern/debug/assert.h"
 #include "kern/trap/trap.h"
 #include "libs/unistd.h"
+#include "libs/error.h"
 #include "kern/driver/clock.h"
+#include "kern/mm/swap.h"
+#include "kern/schedule/sched_edf.h"
+#include "kern/sync/futex.h"
+#include "kern/fs/sysfile.h"
 
 static int
 sys_exit(uint32_t arg[])
+{
+    int error_code = (int)arg[0];
+    return do_exit_group(error_code);
+}
+
+// 只有当前线程退出，线程组里的其它线程继续运行
+static int
+sys_exit_thread(uint32_t arg[])
 {
     int error_code = (int)arg[0];
     return do_exit(error_code);
@@ -23,6 +36,34 @@ sys_fork(uint32_t arg[])
     return do_fork(0, stack, tf);
 }
 
+// 子进程在父进程的虚拟空间和栈上运行，父进程等到子进程exec或者exit才返回
+static int
+sys_vfork(uint32_t arg[])
+{
+    struct trap_frame *tf = g_cur_proc->tf;
+    uintptr_t stack = tf->tf_esp;
+    return do_fork(CLONE_VFORK, stack, tf);
+}
+
+// 创建一个子进程或者线程，stack是它的用户栈，为0时和当前进程用同一个栈地址
+static int
+sys_clone(uint32_t arg[])
+{
+    struct trap_frame *tf = g_cur_proc->tf;
+    uint32_t clone_flags = arg[0];
+    uintptr_t stack = arg[1];
+    // 其它标志只在内核里用
+    if (clone_flags & ~(CLONE_VM | CLONE_THREAD | CLONE_FS | CLONE_VFORK))
+    {
+        return -E_INVAL;
+    }
+    if (stack == 0)
+    {
+        stack = tf->tf_esp;
+    }
+    return do_fork(clone_flags, stack, tf);
+}
+
 static int
 sys_wait(uint32_t arg[])
 {
@@ -39,12 +80,29 @@ static int sys_exec(uint32_t arg[])
     return do_execve(name, argc, argv);
 }
 
+// 直接创建一个运行新程序的子进程，不用先fork再exec
+static int
+sys_spawn(uint32_t arg[])
+{
+    const char *name = (const char *)arg[0];
+    int argc = (int)arg[1];
+    const char **argv = (const char **)arg[2];
+    return do_spawn(name, argc, argv);
+}
+
 static int
 sys_yield(uint32_t arg[])
 {
     return do_yield();
 }
 
+static int
+sys_sleep(uint32_t arg[])
+{
+    unsigned int time = (unsigned int)arg[0];
+    return do_sleep(time);
+}
+
 static int
 sys_kill(uint32_t arg[])
 {
@@ -73,23 +131,212 @@ sys_pgdir(uint32_t arg[])
     return 0;
 }
 
-static uint32_t
+static int
 sys_gettime(uint32_t arg[])
 {
     return (int)g_ticks;
 }
 
+// 设置当前进程的实时参数，period为0时变回普通进程
+static int
+sys_setdeadline(uint32_t arg[])
+{
+    uint32_t runtime = arg[0], deadline = arg[1], period = arg[2];
+    return edf_set_params(g_cur_proc, runtime, deadline, period);
+}
+
+static int
+sys_setpriority(uint32_t arg[])
+{
+    int pid = (int)arg[0];
+    int priority = (int)arg[1];
+    return do_setpriority(pid, priority);
+}
+
+static int
+sys_getpriority(uint32_t arg[])
+{
+    int pid = (int)arg[0];
+    return do_getpriority(pid);
+}
+
+static int
+sys_schedstat(uint32_t arg[])
+{
+    int pid = (int)arg[0];
+    struct schedstat *store = (struct schedstat *)arg[1];
+    return do_schedstat(pid, store);
+}
+
+static int
+sys_sched_setaffinity(uint32_t arg[])
+{
+    int pid = (int)arg[0];
+    uint32_t mask = arg[1];
+    return do_sched_setaffinity(pid, mask);
+}
+
+static int
+sys_sched_getaffinity(uint32_t arg[])
+{
+    int pid = (int)arg[0];
+    uint32_t *mask_store = (uint32_t *)arg[1];
+    return do_sched_getaffinity(pid, mask_store);
+}
+
+static int
+sys_swapstat(uint32_t arg[])
+{
+    struct swapstat *store = (struct swapstat *)arg[0];
+    struct swapstat stat;
+    swap_stat(g_cur_proc->mm, &stat);
+    if (!copy_to_user(g_cur_proc->mm, store, &stat, sizeof(struct swapstat)))
+    {
+        return -E_INVAL;
+    }
+    return 0;
+}
+
+static int
+sys_getrusage(uint32_t arg[])
+{
+    int who = (int)arg[0];
+    struct rusage *store = (struct rusage *)arg[1];
+    return do_getrusage(who, store);
+}
+
+// 用户态锁在需要睡眠或者唤醒别的进程时调用
+static int
+sys_futex(uint32_t arg[])
+{
+    uintptr_t uaddr = arg[0];
+    int op = (int)arg[1], val = (int)arg[2];
+    switch (op)
+    {
+    case FUTEX_WAIT:
+        return do_futex_wait(uaddr, val);
+    case FUTEX_WAKE:
+        return do_futex_wake(uaddr, val);
+    }
+    return -E_INVAL;
+}
+
+static int
+sys_open(uint32_t arg[])
+{
+    const char *path = (const char *)arg[0];
+    uint32_t open_flags = (uint32_t)arg[1];
+    return sysfile_open(path, open_flags);
+}
+
+static int
+sys_close(uint32_t arg[])
+{
+    int fd = (int)arg[0];
+    return sysfile_close(fd);
+}
+
+static int
+sys_read(uint32_t arg[])
+{
+    int fd = (int)arg[0];
+    void *base = (void *)arg[1];
+    size_t len = (size_t)arg[2];
+    return sysfile_read(fd, base, len);
+}
+
+static int
+sys_write(uint32_t arg[])
+{
+    int fd = (int)arg[0];
+    void *base = (void *)arg[1];
+    size_t len = (size_t)arg[2];
+    return sysfile_write(fd, base, len);
+}
+
+static int
+sys_seek(uint32_t arg[])
+{
+    int fd = (int)arg[0];
+    off_t pos = (off_t)arg[1];
+    int whence = (int)arg[2];
+    return sysfile_seek(fd, pos, whence);
+}
+
+static int
+sys_fstat(uint32_t arg[])
+{
+    int fd = (int)arg[0];
+    struct stat *stat = (struct stat *)arg[1];
+    return sysfile_fstat(fd, stat);
+}
+
+static int
+sys_fsync(uint32_t arg[])
+{
+    int fd = (int)arg[0];
+    return sysfile_fsync(fd);
+}
+
+static int
+sys_getcwd(uint32_t arg[])
+{
+    char *buf = (char *)arg[0];
+    size_t len = (size_t)arg[1];
+    return sysfile_getcwd(buf, len);
+}
+
+static int
+sys_getdirentry(uint32_t arg[])
+{
+    int fd = (int)arg[0];
+    struct dirent *direntp = (struct dirent *)arg[1];
+    return sysfile_getdirentry(fd, direntp);
+}
+
+static int
+sys_dup(uint32_t arg[])
+{
+    int fd1 = (int)arg[0];
+    int fd2 = (int)arg[1];
+    return sysfile_dup(fd1, fd2);
+}
+
 static int (*syscalls[])(uint32_t arg[]) = {
     [SYS_exit] = sys_exit,
     [SYS_fork] = sys_fork,
     [SYS_wait] = sys_wait,
     [SYS_exec] = sys_exec,
+    [SYS_clone] = sys_clone,
+    [SYS_exit_thread] = sys_exit_thread,
+    [SYS_spawn] = sys_spawn,
+    [SYS_vfork] = sys_vfork,
     [SYS_yield] = sys_yield,
+    [SYS_sleep] = sys_sleep,
     [SYS_kill] = sys_kill,
     [SYS_getpid] = sys_getpid,
     [SYS_putc] = sys_putc,
     [SYS_pgdir] = sys_pgdir,
     [SYS_gettime] = sys_gettime,
+    [SYS_swapstat] = sys_swapstat,
+    [SYS_setdeadline] = sys_setdeadline,
+    [SYS_setpriority] = sys_setpriority,
+    [SYS_getpriority] = sys_getpriority,
+    [SYS_schedstat] = sys_schedstat,
+    [SYS_sched_setaffinity] = sys_sched_setaffinity,
+    [SYS_sched_getaffinity] = sys_sched_getaffinity,
+    [SYS_futex] = sys_futex,
+    [SYS_getrusage] = sys_getrusage,
+    [SYS_open] = sys_open,
+    [SYS_close] = sys_close,
+    [SYS_read] = sys_read,
+    [SYS_write] = sys_write,
+    [SYS_seek] = sys_seek,
+    [SYS_fstat] = sys_fstat,
+    [SYS_fsync] = sys_fsync,
+    [SYS_getcwd] = sys_getcwd,
+    [SYS_getdirentry] = sys_getdirentry,
+    [SYS_dup] = sys_dup,
 };
 
 #define NUM_SYSCALLS ((sizeof(syscalls)) / (sizeof(syscalls[0])))
@@ -11,13 +11,9 @@
 #include "kern/mm/vmm.h"
 #include "kern/process/proc.h"
 #include "kern/syscall/syscall.h"
-
-#define TICK_NUM 100
-
-static void print_ticks()
-{
-    cprintf("%d ticks\n", TICK_NUM);
-}
+#include "kern/schedule/sched.h"
+#include "kern/process/cpu.h"
+#include "kern/driver/lapic.h"
 
 // 中断向量表
 static struct gate_desc g_idt[256];
@@ -39,6 +35,12 @@ void idt_init(void)
     lidt(&g_idt_desc);
 }
 
+// AP共用BSP初始化好的中断描述符表
+void idt_load(void)
+{
+    lidt(&g_idt_desc);
+}
+
 void print_regs(struct pushal_regs *regs)
 {
     cprintf("  edi  0x%08x\n", regs->reg_edi);
@@ -160,7 +162,6 @@ print_pgfault(struct trap_frame *tf)
 
 static int pgfault_handler(struct trap_frame *tf)
 {
-    print_pgfault(tf);
     struct mm_struct *mm;
     if (g_cur_proc == NULL)
     {
@@ -194,6 +195,7 @@ static void trap_dispatch(struct trap_frame *tf)
     case T_PGFLT:
         if ((ret = pgfault_handler(tf)) != 0)
         {
+            print_pgfault(tf);
             panic("handle pgfault failed. ret=%d\n", ret);
             print_trap_frame(tf);
             if (g_cur_proc == NULL)
@@ -216,12 +218,24 @@ static void trap_dispatch(struct trap_frame *tf)
         syscall(tf);
         break;
     case IRQ_OFFSET + IRQ_TIMER:
-        g_ticks++;
-        if (g_ticks % 100 == 0)
-        {
-            print_ticks();
-        }
-
+        clock_tick();
+        // 时钟中断驱动定时器和调度器，时间片用完的进程在返回用户态前被抢占
+        run_timer_list(!trap_in_kernel(tf));
+        break;
+    case T_LAPIC_TIMER:
+        // AP的时钟中断只驱动调度器，g_ticks由BSP的时钟中断更新
+        lapic_eoi();
+        run_timer_list(!trap_in_kernel(tf));
+        break;
+    case T_IPI_RESCHED:
+        lapic_eoi();
+        g_cur_proc->need_resched = 1;
+        break;
+    case T_LAPIC_ERROR:
+        lapic_eoi();
+        cprintf("cpu%d: lapic error.\n", this_cpu()->id);
+        break;
+    case T_LAPIC_SPURIOUS:
         break;
     // case IRQ_OFFSET + IRQ_COM1:
     //     c = cons_getc();
@@ -251,8 +265,44 @@ bool trap_in_kernel(struct trap_frame *tf)
 }
 
 // 处理中断
+/* *
+ * sysenter_trap - called by __sysenter_entry with a trap frame built like the
+ * one of int 0x80. The user stub pushed its return address and made %ebp
+ * point to it, so it is read from there, and the frame then goes through
+ * trap() like any other syscall. trap() releases the kernel lock on its way
+ * back to user mode.
+ * */
+void sysenter_trap(struct trap_frame *tf)
+{
+    kernel_lock();
+    uintptr_t eip;
+    if (!copy_from_user(g_cur_proc->mm, &eip, (void *)tf->tf_esp, sizeof(uintptr_t), 0))
+    {
+        do_exit(-E_FAULT);
+    }
+    tf->tf_eip = eip;
+    tf->tf_esp += sizeof(uintptr_t);
+    trap(tf);
+}
+
 void trap(struct trap_frame *tf)
 {
+    // TLB shootdown不用拿大内核锁，发起的CPU正持有锁等着我们
+    if (tf->tf_trapno == T_IPI_TLB)
+    {
+        tlb_flush_local();
+        lapic_eoi();
+        return;
+    }
+
+    // 从用户态进来，或者打断了正在停机的idle进程时，要先拿到大内核锁
+    bool locked = 0;
+    if (!kernel_lock_held())
+    {
+        kernel_lock();
+        locked = 1;
+    }
+
     // dispatch based on what type of trap occurred
     // used for previous projects
     if (g_cur_proc == NULL)
@@ -274,7 +324,7 @@ void trap(struct trap_frame *tf)
         {
             if (g_cur_proc->flags & PF_EXITING)
             {
-                do_exit(-E_KILLED);
+                do_exit(g_cur_proc->exit_code);
             }
             if (g_cur_proc->need_resched)
             {
@@ -282,4 +332,10 @@ void trap(struct trap_frame *tf)
             }
         }
     }
+
+    // 返回用户态前释放大内核锁，exec会把内核线程的trap_frame改成用户态的
+    if (locked || !trap_in_kernel(tf))
+    {
+        kernel_unlock();
+    }
 }
@@ -29,6 +29,13 @@
 
 #define T_SYSCALL 0x80 // SYSCALL, ONLY FOR THIS PROJ
 
+// local APIC的中断，紧接在8259A的16个IRQ后面
+#define T_LAPIC_TIMER 48     // AP的时钟中断
+#define T_IPI_RESCHED 49     // 要求目标CPU重新调度
+#define T_IPI_TLB 50         // 要求目标CPU刷新TLB
+#define T_LAPIC_ERROR 51     // local APIC出错
+#define T_LAPIC_SPURIOUS 255 // 伪中断，不需要EOI
+
 /* *
  * These are arbitrarily chosen, but with care not to overlap
  * processor defined exceptions or interrupt vectors.
@@ -139,5 +146,9 @@ struct gate_desc
 #define SET_CGATE(gate, off, ss, args, dpl) SET_GATE(gate, off, ss, args, STS_CG32, dpl) // 调用门
 
 void idt_init(void); // 初始化中断描述符表
+void idt_load(void); // AP加载中断描述符表
+bool trap_in_kernel(struct trap_frame *tf);
+void trap(struct trap_frame *tf);
+void sysenter_trap(struct trap_frame *tf); // sysenter进来的系统调用
 
 #endif // __KERN_TRAP_TRAP_H__
@@ -89,4 +89,45 @@ test_and_clear_bit(int nr, volatile void *addr)
     return oldbit != 0;
 }
 
+/* *
+ * atomic_xchg - Atomically store @val into *@addr and return the old value
+ * */
+static inline int
+atomic_xchg(volatile int *addr, int val)
+{
+    asm volatile("xchgl %0, %1"
+                 : "+r"(val), "+m"(*addr)
+                 :
+                 : "memory");
+    return val;
+}
+
+/* *
+ * atomic_cmpxchg - Atomically store @new into *@addr if it equals @old
+ * @return: the value *@addr had before, the store happened if it is @old
+ * */
+static inline int
+atomic_cmpxchg(volatile int *addr, int old, int new)
+{
+    int prev;
+    asm volatile("lock; cmpxchgl %2, %1"
+                 : "=a"(prev), "+m"(*addr)
+                 : "r"(new), "0"(old)
+                 : "memory");
+    return prev;
+}
+
+/* *
+ * atomic_add - Atomically add @val to *@addr and return the old value
+ * */
+static inline int
+atomic_add(volatile int *addr, int val)
+{
+    asm volatile("lock; xaddl %0, %1"
+                 : "+r"(val), "+m"(*addr)
+                 :
+                 : "memory");
+    return val;
+}
+
 #endif /* !__LIBS_ATOMIC_H__ */
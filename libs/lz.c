@@ -0,0 +1,206 @@
+#include "libs/lz.h"
+#include "libs/stdlib.h"
+#include "libs/string.h"
+
+#define LZ_HASH_LOG 10
+#define LZ_HASH_SIZE (1 << LZ_HASH_LOG)
+
+#define LZ_READ3(p) (((uint32_t)(p)[0] << 16) | ((p)[1] << 8) | (p)[2])
+
+// 记录最近一次出现某个3字节前缀的位置（相对输入起点）
+// 表项只是提示，使用前会重新比较内容，所以不需要每次压缩前清空
+static uint16_t lz_htab[LZ_HASH_SIZE];
+
+/* *
+ * lz_compress - compress @in_len bytes at @in_data into @out_data
+ * @in_data:    the input buffer, at most 64KB
+ * @in_len:     the number of bytes to compress
+ * @out_data:   the output buffer
+ * @out_len:    the capacity of @out_data
+ *
+ * The lz_compress() function returns the number of bytes written to
+ * @out_data, or 0 if the result doesn't fit in @out_len bytes. It keeps
+ * its hash table in static storage, so callers must not run it
+ * concurrently.
+ * */
+size_t
+lz_compress(const void *in_data, size_t in_len, void *out_data, size_t out_len)
+{
+    const uint8_t *in = in_data, *ip = in, *in_end = in + in_len;
+    uint8_t *out = out_data, *op = out, *out_end = out + out_len;
+    size_t lit = 0;
+
+    if (in_len == 0 || in_len > (1 << 16) || out_len < 2)
+    {
+        return 0;
+    }
+
+    // 预留第一段原样字节的控制字节
+    op++;
+    while (ip + 2 < in_end)
+    {
+        uint32_t h = hash32(LZ_READ3(ip), LZ_HASH_LOG);
+        const uint8_t *ref = in + lz_htab[h];
+        lz_htab[h] = ip - in;
+
+        size_t off = ip - ref - 1;
+        if (ref < ip && off < LZ_MAX_OFF && LZ_READ3(ref) == LZ_READ3(ip))
+        {
+            size_t len = 3, maxlen = in_end - ip;
+            if (maxlen > LZ_MAX_REF)
+            {
+                maxlen = LZ_MAX_REF;
+            }
+            while (len < maxlen && ref[len] == ip[len])
+            {
+                len++;
+            }
+
+            // 回引用最多3字节，再加上下一段原样字节的控制字节
+            if (op + 4 > out_end)
+            {
+                return 0;
+            }
+
+            // 结束当前这一段原样字节，空段就收回预留的控制字节
+            if (lit != 0)
+            {
+                op[-lit - 1] = lit - 1;
+            }
+            else
+            {
+                op--;
+            }
+
+            // 匹配区间内的位置也加入哈希表，后面才能引用到它们
+            const uint8_t *p = ip + 1;
+            ip += len;
+            for (; p < ip && p + 2 < in_end; p++)
+            {
+                lz_htab[hash32(LZ_READ3(p), LZ_HASH_LOG)] = p - in;
+            }
+
+            len -= 2;
+            if (len < 7)
+            {
+                *op++ = (off >> 8) + (len << 5);
+            }
+            else
+            {
+                *op++ = (off >> 8) + (7 << 5);
+                *op++ = len - 7;
+            }
+            *op++ = off;
+
+            lit = 0;
+            op++;
+            continue;
+        }
+
+        if (op >= out_end)
+        {
+            return 0;
+        }
+        *op++ = *ip++;
+        if (++lit == LZ_MAX_LIT)
+        {
+            op[-lit - 1] = lit - 1;
+            lit = 0;
+            if (op >= out_end)
+            {
+                return 0;
+            }
+            op++;
+        }
+    }
+
+    // 剩下不足3字节的尾巴原样输出
+    while (ip < in_end)
+    {
+        if (op >= out_end)
+        {
+            return 0;
+        }
+        *op++ = *ip++;
+        if (++lit == LZ_MAX_LIT)
+        {
+            op[-lit - 1] = lit - 1;
+            lit = 0;
+            if (op >= out_end)
+            {
+                return 0;
+            }
+            op++;
+        }
+    }
+
+    if (lit != 0)
+    {
+        op[-lit - 1] = lit - 1;
+    }
+    else
+    {
+        op--;
+    }
+    return op - out;
+}
+
+/* *
+ * lz_decompress - decompress @in_len bytes at @in_data into @out_data
+ * @in_data:    the buffer produced by lz_compress
+ * @in_len:     the size of the compressed data
+ * @out_data:   the output buffer
+ * @out_len:    the capacity of @out_data
+ *
+ * The lz_decompress() function returns the number of bytes written to
+ * @out_data, or 0 if the input is corrupted or doesn't fit in @out_len.
+ * */
+size_t
+lz_decompress(const void *in_data, size_t in_len, void *out_data, size_t out_len)
+{
+    const uint8_t *ip = in_data, *in_end = ip + in_len;
+    uint8_t *out = out_data, *op = out, *out_end = out + out_len;
+
+    while (ip < in_end)
+    {
+        size_t ctrl = *ip++;
+        if (ctrl < LZ_MAX_LIT)
+        {
+            ctrl++;
+            if (op + ctrl > out_end || ip + ctrl > in_end)
+            {
+                return 0;
+            }
+            memcpy(op, ip, ctrl);
+            op += ctrl, ip += ctrl;
+        }
+        else
+        {
+            size_t len = ctrl >> 5;
+            if (len == 7)
+            {
+                if (ip >= in_end)
+                {
+                    return 0;
+                }
+                len += *ip++;
+            }
+            len += 2;
+            if (ip >= in_end)
+            {
+                return 0;
+            }
+            const uint8_t *ref = op - ((ctrl & 0x1f) << 8) - 1 - *ip++;
+            if (ref < out || op + len > out_end)
+            {
+                return 0;
+            }
+            // 源和目的可能重叠，只能逐字节拷贝
+            while (len-- > 0)
+            {
+                *op++ = *ref++;
+            }
+        }
+    }
+    return op - out;
+}
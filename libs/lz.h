@@ -0,0 +1,23 @@
+#ifndef __LIBS_LZ_H__
+#define __LIBS_LZ_H__
+
+#include "libs/defs.h"
+
+/* *
+ * 简单的LZ77压缩（LZF格式），用于压缩页等小块数据
+ *
+ * 编码由一串控制字节开头的记录组成：
+ *   000LLLLL                   : 后面跟着L+1个原样字节
+ *   LLLOOOOO OOOOOOOO          : 回引用，长度L+2，偏移O+1
+ *   111OOOOO LLLLLLLL OOOOOOOO : 回引用，长度L+9，偏移O+1
+ * */
+
+#define LZ_MAX_LIT (1 << 5)              // 一段原样字节的最大长度
+#define LZ_MAX_OFF (1 << 13)             // 回引用的最大偏移
+#define LZ_MAX_REF ((1 << 8) + (1 << 3)) // 回引用的最大长度
+
+/* libs/lz.c */
+size_t lz_compress(const void *in_data, size_t in_len, void *out_data, size_t out_len);
+size_t lz_decompress(const void *in_data, size_t in_len, void *out_data, size_t out_len);
+
+#endif /* !__LIBS_LZ_H__ */
@@ -0,0 +1,292 @@
+#include "libs/rb_tree.h"
+
+#define rb_is_red(node) ((node) != NULL && (node)->red)
+
+// 把node换成new挂到node的父节点上
+static inline void
+rb_replace_child(rb_tree_t *tree, rb_node_t *node, rb_node_t *new)
+{
+    rb_node_t *parent = node->parent;
+    if (parent == NULL)
+    {
+        tree->root = new;
+    }
+    else if (parent->left == node)
+    {
+        parent->left = new;
+    }
+    else
+    {
+        parent->right = new;
+    }
+}
+
+/* *
+ * 左旋：
+ *      x              y
+ *     / \            / \
+ *    a   y    =>    x   c
+ *       / \        / \
+ *      b   c      a   b
+ * */
+static void
+rb_rotate_left(rb_tree_t *tree, rb_node_t *x)
+{
+    rb_node_t *y = x->right;
+    x->right = y->left;
+    if (y->left != NULL)
+    {
+        y->left->parent = x;
+    }
+    y->parent = x->parent;
+    rb_replace_child(tree, x, y);
+    y->left = x;
+    x->parent = y;
+}
+
+static void
+rb_rotate_right(rb_tree_t *tree, rb_node_t *x)
+{
+    rb_node_t *y = x->left;
+    x->left = y->right;
+    if (y->right != NULL)
+    {
+        y->right->parent = x;
+    }
+    y->parent = x->parent;
+    rb_replace_child(tree, x, y);
+    y->right = x;
+    x->parent = y;
+}
+
+/* *
+ * rb_insert - insert @node into @tree
+ * */
+void rb_insert(rb_tree_t *tree, rb_node_t *node)
+{
+    rb_node_t *parent = NULL, **link = &(tree->root);
+    bool leftmost = 1;
+    while (*link != NULL)
+    {
+        parent = *link;
+        if (tree->compare(node, parent) < 0)
+        {
+            link = &(parent->left);
+        }
+        else
+        {
+            link = &(parent->right);
+            leftmost = 0;
+        }
+    }
+    node->parent = parent;
+    node->left = node->right = NULL;
+    node->red = 1;
+    *link = node;
+    if (leftmost)
+    {
+        tree->leftmost = node;
+    }
+
+    // 父节点是红色的时候违反了性质，向上调整
+    while ((parent = node->parent) != NULL && parent->red)
+    {
+        rb_node_t *gparent = parent->parent;
+        if (parent == gparent->left)
+        {
+            rb_node_t *uncle = gparent->right;
+            if (rb_is_red(uncle))
+            {
+                parent->red = uncle->red = 0;
+                gparent->red = 1;
+                node = gparent;
+                continue;
+            }
+            if (node == parent->right)
+            {
+                rb_rotate_left(tree, parent);
+                node = parent;
+                parent = node->parent;
+            }
+            parent->red = 0;
+            gparent->red = 1;
+            rb_rotate_right(tree, gparent);
+        }
+        else
+        {
+            rb_node_t *uncle = gparent->left;
+            if (rb_is_red(uncle))
+            {
+                parent->red = uncle->red = 0;
+                gparent->red = 1;
+                node = gparent;
+                continue;
+            }
+            if (node == parent->left)
+            {
+                rb_rotate_right(tree, parent);
+                node = parent;
+                parent = node->parent;
+            }
+            parent->red = 0;
+            gparent->red = 1;
+            rb_rotate_left(tree, gparent);
+        }
+    }
+    tree->root->red = 0;
+}
+
+// 删掉一个黑色节点之后，node（可能为NULL）所在的子树少了一个黑色节点，向上调整
+static void
+rb_delete_fixup(rb_tree_t *tree, rb_node_t *node, rb_node_t *parent)
+{
+    while (node != tree->root && !rb_is_red(node))
+    {
+        if (node == parent->left)
+        {
+            rb_node_t *sibling = parent->right;
+            if (sibling->red)
+            {
+                sibling->red = 0;
+                parent->red = 1;
+                rb_rotate_left(tree, parent);
+                sibling = parent->right;
+            }
+            if (!rb_is_red(sibling->left) && !rb_is_red(sibling->right))
+            {
+                sibling->red = 1;
+                node = parent;
+                parent = node->parent;
+                continue;
+            }
+            if (!rb_is_red(sibling->right))
+            {
+                sibling->left->red = 0;
+                sibling->red = 1;
+                rb_rotate_right(tree, sibling);
+                sibling = parent->right;
+            }
+            sibling->red = parent->red;
+            parent->red = 0;
+            sibling->right->red = 0;
+            rb_rotate_left(tree, parent);
+            node = tree->root;
+        }
+        else
+        {
+            rb_node_t *sibling = parent->left;
+            if (sibling->red)
+            {
+                sibling->red = 0;
+                parent->red = 1;
+                rb_rotate_right(tree, parent);
+                sibling = parent->left;
+            }
+            if (!rb_is_red(sibling->left) && !rb_is_red(sibling->right))
+            {
+                sibling->red = 1;
+                node = parent;
+                parent = node->parent;
+                continue;
+            }
+            if (!rb_is_red(sibling->left))
+            {
+                sibling->right->red = 0;
+                sibling->red = 1;
+                rb_rotate_left(tree, sibling);
+                sibling = parent->left;
+            }
+            sibling->red = parent->red;
+            parent->red = 0;
+            sibling->left->red = 0;
+            rb_rotate_right(tree, parent);
+            node = tree->root;
+        }
+    }
+    if (node != NULL)
+    {
+        node->red = 0;
+    }
+}
+
+/* *
+ * rb_delete - remove @node from @tree
+ * */
+void rb_delete(rb_tree_t *tree, rb_node_t *node)
+{
+    if (tree->leftmost == node)
+    {
+        tree->leftmost = rb_next(node);
+    }
+
+    rb_node_t *child, *parent;
+    bool red;
+    if (node->left != NULL && node->right != NULL)
+    {
+        // 有两个子节点，用后继节点顶替node的位置，相当于删掉了后继节点
+        rb_node_t *next = node->right;
+        while (next->left != NULL)
+        {
+            next = next->left;
+        }
+        child = next->right;
+        red = next->red;
+        if (next->parent == node)
+        {
+            parent = next;
+        }
+        else
+        {
+            parent = next->parent;
+            parent->left = child;
+            next->right = node->right;
+            node->right->parent = next;
+        }
+        if (child != NULL)
+        {
+            child->parent = parent;
+        }
+        next->left = node->left;
+        node->left->parent = next;
+        next->red = node->red;
+        next->parent = node->parent;
+        rb_replace_child(tree, node, next);
+    }
+    else
+    {
+        child = (node->left != NULL) ? node->left : node->right;
+        parent = node->parent;
+        red = node->red;
+        if (child != NULL)
+        {
+            child->parent = parent;
+        }
+        rb_replace_child(tree, node, child);
+    }
+
+    if (!red)
+    {
+        rb_delete_fixup(tree, child, parent);
+    }
+}
+
+/* *
+ * rb_next - get the node after @node in order, NULL if @node is the last one
+ * */
+rb_node_t *rb_next(rb_node_t *node)
+{
+    if (node->right != NULL)
+    {
+        node = node->right;
+        while (node->left != NULL)
+        {
+            node = node->left;
+        }
+        return node;
+    }
+    while (node->parent != NULL && node == node->parent->right)
+    {
+        node = node->parent;
+    }
+    return node->parent;
+}
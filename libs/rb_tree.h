@@ -0,0 +1,51 @@
+#ifndef __LIBS_RB_TREE_H__
+#define __LIBS_RB_TREE_H__
+
+#include "libs/defs.h"
+
+/* *
+ * 侵入式红黑树，节点嵌在使用者的结构体里，用to_struct取回外层结构
+ * 插入和删除都是O(log n)且不递归，最左边（最小）的节点缓存在树里，O(1)取得
+ * 比较结果相等的节点插在已有节点的后面
+ * */
+
+typedef struct rb_node
+{
+    struct rb_node *parent, *left, *right;
+    bool red;
+} rb_node_t;
+
+typedef int (*rb_compare_f)(rb_node_t *a, rb_node_t *b);
+
+typedef struct rb_tree
+{
+    rb_node_t *root;
+    rb_node_t *leftmost;  // 最小的节点
+    rb_compare_f compare; // a小于b时返回负数
+} rb_tree_t;
+
+static inline void
+rb_tree_init(rb_tree_t *tree, rb_compare_f compare)
+{
+    tree->root = tree->leftmost = NULL;
+    tree->compare = compare;
+}
+
+static inline rb_node_t *
+rb_first(rb_tree_t *tree)
+{
+    return tree->leftmost;
+}
+
+static inline bool
+rb_tree_empty(rb_tree_t *tree)
+{
+    return tree->root == NULL;
+}
+
+/* libs/rb_tree.c */
+void rb_insert(rb_tree_t *tree, rb_node_t *node);
+void rb_delete(rb_tree_t *tree, rb_node_t *node);
+rb_node_t *rb_next(rb_node_t *node);
+
+#endif /* !__LIBS_RB_TREE_H__ */
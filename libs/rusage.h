@@ -0,0 +1,23 @@
+#ifndef __LIBS_RUSAGE_H__
+#define __LIBS_RUSAGE_H__
+
+#include "libs/defs.h"
+
+// SYS_getrusage的who参数
+#define RUSAGE_SELF 0       // 当前进程
+#define RUSAGE_CHILDREN (-1) // 已经回收的子进程以及它们回收的子孙进程的总和
+
+// SYS_getrusage返回的资源使用情况，时间都以tick为单位
+struct rusage
+{
+    size_t ru_utime;         // 在用户态运行的时间
+    size_t ru_stime;         // 在内核态运行的时间
+    size_t ru_nvcsw;         // 主动让出CPU（睡眠、等待）的次数
+    size_t ru_nivcsw;        // 被抢占或者yield让出CPU的次数
+    size_t ru_minflt;        // 不需要读交换磁盘就能处理的缺页次数
+    size_t ru_majflt;        // 需要读交换磁盘的缺页次数
+    uint64_t ru_read_bytes;  // 读文件的字节数
+    uint64_t ru_write_bytes; // 写文件的字节数
+};
+
+#endif /* !__LIBS_RUSAGE_H__ */
@@ -0,0 +1,18 @@
+#ifndef __LIBS_SCHEDSTAT_H__
+#define __LIBS_SCHEDSTAT_H__
+
+#include "libs/defs.h"
+
+// SYS_schedstat返回的进程调度统计信息，时间都以tick为单位
+struct schedstat
+{
+    size_t sc_runs;       // 被调度运行的次数
+    size_t sc_run_ticks;  // 在CPU上运行的时间
+    size_t sc_wait_ticks; // 在运行队列里等待的时间
+    size_t sc_nvcsw;      // 主动让出CPU（睡眠、等待）的次数
+    size_t sc_nivcsw;     // 被抢占或者yield让出CPU的次数
+    size_t sc_migrations; // 被负载均衡迁移到别的CPU的次数
+    size_t sc_cpu;        // 最近一次所在的CPU
+};
+
+#endif /* !__LIBS_SCHEDSTAT_H__ */
@@ -0,0 +1,26 @@
+#ifndef __LIBS_SWAPSTAT_H__
+#define __LIBS_SWAPSTAT_H__
+
+#include "libs/defs.h"
+
+// SYS_swapstat返回的交换子系统统计信息
+struct swapstat
+{
+    // 当前进程（所在的mm）
+    size_t ss_minflt;  // 不需要读交换磁盘就能处理的缺页次数
+    size_t ss_majflt;  // 需要读交换磁盘的缺页次数
+    size_t ss_swapin;  // 换入的页数
+    size_t ss_swapout; // 换出的页数
+
+    // 全局
+    size_t ss_slots_used;    // 交换磁盘上正在使用的槽位数
+    size_t ss_slots_total;   // 交换磁盘上的槽位总数
+    size_t ss_zswap_pages;   // 压缩交换池里的页数
+    size_t ss_zswap_bytes;   // 压缩交换池里压缩后的字节数
+    uint64_t ss_read_bytes;  // 从交换磁盘读的字节数
+    uint64_t ss_write_bytes; // 写到交换磁盘的字节数
+    size_t ss_swapin_total;  // 换入的总次数
+    size_t ss_swapin_ticks;  // 换入的平均延迟（ticks）
+};
+
+#endif /* !__LIBS_SWAPSTAT_H__ */
@@ -9,6 +9,9 @@
 #define SYS_wait 3
 #define SYS_exec 4
 #define SYS_clone 5
+#define SYS_exit_thread 6
+#define SYS_spawn 7
+#define SYS_vfork 8
 #define SYS_yield 10
 #define SYS_sleep 11
 #define SYS_kill 12
@@ -19,6 +22,15 @@
 #define SYS_shmem 22
 #define SYS_putc 30
 #define SYS_pgdir 31
+#define SYS_swapstat 32
+#define SYS_setdeadline 33
+#define SYS_setpriority 34
+#define SYS_getpriority 35
+#define SYS_schedstat 36
+#define SYS_sched_setaffinity 37
+#define SYS_sched_getaffinity 38
+#define SYS_futex 39
+#define SYS_getrusage 40
 #define SYS_open 100
 #define SYS_close 101
 #define SYS_read 102
@@ -34,6 +46,11 @@
 #define CLONE_VM 0x00000100     // set if VM shared between processes
 #define CLONE_THREAD 0x00000200 // thread group
 #define CLONE_FS 0x00000800     // set if shared between processes
+#define CLONE_VFORK 0x00004000  // parent sleeps until the child execs or exits
+
+/* SYS_futex operations */
+#define FUTEX_WAIT 0 // sleep if *addr == val
+#define FUTEX_WAKE 1 // wake up at most val waiters
 
 /* VFS flags */
 // flags for open: choose one of these
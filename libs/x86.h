@@ -62,6 +62,91 @@ static inline void cli(void)
                              : "memory");
 }
 
+// 允许外部中断并停机直到下一个中断到来
+// sti要等下一条指令执行完才生效，所以在cli状态下检查完条件再调用不会错过中断
+static inline void sti_hlt(void)
+{
+    __asm__ __volatile__("sti; hlt" ::
+                             : "memory");
+}
+
+// 读时间戳计数器
+static inline uint64_t rdtsc(void)
+{
+    uint64_t tsc;
+    __asm__ __volatile__("rdtsc"
+                         : "=A"(tsc));
+    return tsc;
+}
+
+// 读取cpuid的信息，不需要的输出可以传NULL
+static inline void cpuid(uint32_t info, uint32_t *eaxp, uint32_t *ebxp, uint32_t *ecxp, uint32_t *edxp)
+{
+    uint32_t eax, ebx, ecx, edx;
+    __asm__ __volatile__("cpuid"
+                         : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx)
+                         : "a"(info));
+    if (eaxp != NULL)
+    {
+        *eaxp = eax;
+    }
+    if (ebxp != NULL)
+    {
+        *ebxp = ebx;
+    }
+    if (ecxp != NULL)
+    {
+        *ecxp = ecx;
+    }
+    if (edxp != NULL)
+    {
+        *edxp = edx;
+    }
+}
+
+#define CPUID_FEAT_SEP (1 << 11) // cpuid 1的edx：支持sysenter/sysexit
+
+// 是否能用sysenter/sysexit做系统调用，用户态也可以调用
+static inline bool cpu_has_sysenter(void)
+{
+    uint32_t eax, edx;
+    cpuid(1, &eax, NULL, NULL, &edx);
+    // 早期的Pentium Pro报告了SEP但其实不支持
+    uint32_t family = (eax >> 8) & 0xF, model = (eax >> 4) & 0xF, stepping = eax & 0xF;
+    if (family == 6 && model < 3 && stepping < 3)
+    {
+        return 0;
+    }
+    return (edx & CPUID_FEAT_SEP) != 0;
+}
+
+// sysenter用到的MSR
+#define MSR_SYSENTER_CS 0x174
+#define MSR_SYSENTER_ESP 0x175
+#define MSR_SYSENTER_EIP 0x176
+
+static inline void wrmsr(uint32_t msr, uint64_t val)
+{
+    __asm__ __volatile__("wrmsr" ::"c"(msr), "A"(val));
+}
+
+// 原子地交换*addr和val，返回原来的值，xchg自带lock语义
+static inline uint32_t xchg(volatile uint32_t *addr, uint32_t val)
+{
+    __asm__ __volatile__("xchgl %0, %1"
+                         : "+m"(*addr), "+r"(val)
+                         :
+                         : "memory");
+    return val;
+}
+
+// 自旋等待时提示CPU降低功耗，也让超线程的兄弟核跑得更快
+static inline void pause(void)
+{
+    __asm__ __volatile__("pause" ::
+                             : "memory");
+}
+
 // 用来描述gdt和idt和ldt表信息
 struct dt_desc
 {
@@ -89,6 +174,16 @@ static inline void ltr(uint16_t sel)
                          : "memory");
 }
 
+// 最低的为1的位的序号，x不能为0
+static inline uint32_t bsf(uint32_t x)
+{
+    uint32_t index;
+    __asm__("bsfl %1, %0"
+            : "=r"(index)
+            : "rm"(x));
+    return index;
+}
+
 #define do_div(n, base) ({                               \
     unsigned long __upper, __low, __high, __mod, __base; \
     __base = (base);                                     \
@@ -0,0 +1,125 @@
+#include <ulib.h>
+#include <stdio.h>
+
+/* *
+ * affinity - pin workers to CPUs and check where they run
+ *
+ * Two workers are pinned to each online CPU. While spinning for RUN_MSEC
+ * every worker keeps checking the CPU it last ran on, and exits with the
+ * number of times it found itself somewhere else, which must be 0 even
+ * though the load balancer tries to even out the CPUs.
+ *
+ * Then a real-time process that is throttled most of the time is moved
+ * from CPU to CPU, and must end up running on the last CPU it was given.
+ * */
+
+#define RUN_MSEC    2000
+#define MAX_WORK    16
+#define EDF_MSEC    1000
+
+// 掩码里第n个CPU的编号
+static int
+nth_cpu(unsigned int mask, int n) {
+    int cpu;
+    for (cpu = 0; cpu < 32; cpu ++) {
+        if ((mask & (1 << cpu)) && n -- == 0) {
+            return cpu;
+        }
+    }
+    return -1;
+}
+
+static int
+worker(int cpu, unsigned int end) {
+    int wrong = 0;
+    assert(sched_setaffinity(0, 1 << cpu) == 0);
+    while (gettime_msec() < end) {
+        struct schedstat s;
+        assert(schedstat(0, &s) == 0);
+        if (s.sc_cpu != cpu) {
+            wrong ++;
+        }
+    }
+    return wrong;
+}
+
+// 每个周期10个tick只能运行1个tick，剩下的时间都被挂起，改掩码多半赶上它被挂起的时候
+static void
+edf_migrate(unsigned int online, int ncpu) {
+    int pid, i, last = -1;
+    unsigned int end = gettime_msec() + EDF_MSEC;
+    if ((pid = fork()) == 0) {
+        struct schedstat s;
+        assert(setdeadline(1, 10, 10) == 0);
+        // 父进程最后把它固定到last上，多等几个周期让它迁移过去
+        while (gettime_msec() < end + 200)
+            /* do nothing */;
+        assert(schedstat(0, &s) == 0);
+        exit(s.sc_cpu);
+    }
+    assert(pid > 0);
+    for (i = 0; gettime_msec() < end; i ++) {
+        last = nth_cpu(online, i % ncpu);
+        assert(sched_setaffinity(pid, 1 << last) == 0);
+        sleep(3);
+    }
+    int cpu;
+    assert(waitpid(pid, &cpu) == 0);
+    cprintf("real-time process pinned %d times, last to cpu%d, ran on cpu%d\n", i, last, cpu);
+    assert(cpu == last);
+}
+
+int
+main(void) {
+    unsigned int online, mask;
+    int ncpu = 0, nwork, i, pid;
+
+    assert(sched_getaffinity(0, &online) == 0);
+    for (i = 0; i < 32; i ++) {
+        if (online & (1 << i)) {
+            ncpu ++;
+        }
+    }
+    assert(ncpu > 0);
+    cprintf("%d cpus online, mask 0x%x\n", ncpu, online);
+
+    // 不在线的CPU会被忽略，一个在线的都没有就是错的
+    assert(sched_setaffinity(0, 0) != 0);
+    assert(sched_setaffinity(0, ~online) != 0 || ncpu == 32);
+    assert(sched_setaffinity(0, ~0) == 0);
+    assert(sched_getaffinity(0, &mask) == 0 && mask == online);
+
+    // 子进程继承父进程的掩码
+    int last = nth_cpu(online, ncpu - 1);
+    assert(sched_setaffinity(0, 1 << last) == 0);
+    if ((pid = fork()) == 0) {
+        assert(sched_getaffinity(0, &mask) == 0 && mask == (1 << last));
+        exit(0);
+    }
+    assert(pid > 0 && waitpid(pid, NULL) == 0);
+    assert(sched_setaffinity(0, online) == 0);
+
+    int pids[MAX_WORK], cpus[MAX_WORK];
+    unsigned int end = gettime_msec() + RUN_MSEC;
+    nwork = (ncpu * 2 < MAX_WORK) ? ncpu * 2 : MAX_WORK;
+    for (i = 0; i < nwork; i ++) {
+        cpus[i] = nth_cpu(online, i % ncpu);
+        if ((pids[i] = fork()) == 0) {
+            exit(worker(cpus[i], end));
+        }
+        assert(pids[i] > 0);
+    }
+
+    int failed = 0;
+    for (i = 0; i < nwork; i ++) {
+        int wrong;
+        assert(waitpid(pids[i], &wrong) == 0);
+        cprintf("worker %d pinned to cpu%d: %d checks on a wrong cpu\n", i, cpus[i], wrong);
+        failed += wrong;
+    }
+    assert(failed == 0);
+
+    edf_migrate(online, ncpu);
+    cprintf("affinity pass.\n");
+    return 0;
+}
@@ -0,0 +1,65 @@
+#include <ulib.h>
+#include <stdio.h>
+
+/* *
+ * balance - completion time skew of CPU-bound processes on SMP
+ *
+ * NWORK children each run the same fixed amount of work. Without load
+ * balancing the children stay on the CPU they were first put on, so the
+ * ones sharing a CPU finish late. With it the completion times of all the
+ * children should be close. Run it with different numbers of CPUs
+ * (qemu -smp M) and compare the skew, (max - min) / avg.
+ * */
+
+#define NWORK       8
+#define WORK_KLOOPS 200000
+
+static void
+work(void) {
+    volatile unsigned int loops = 0;
+    int i, j;
+    for (i = 0; i < WORK_KLOOPS; i ++) {
+        for (j = 0; j < 1000; j ++) {
+            loops ++;
+        }
+    }
+}
+
+int
+main(void) {
+    int pids[NWORK], done[NWORK];
+    unsigned int start = gettime_msec();
+    int i;
+
+    for (i = 0; i < NWORK; i ++) {
+        if ((pids[i] = fork()) == 0) {
+            work();
+            struct schedstat s;
+            assert(schedstat(0, &s) == 0);
+            cprintf("worker %d: run %d ticks, wait %d ticks, migrations %d\n",
+                    i, s.sc_run_ticks, s.sc_wait_ticks, s.sc_migrations);
+            // 以完成时间作为退出码返回
+            exit(gettime_msec() - start);
+        }
+        assert(pids[i] > 0);
+    }
+
+    int min = -1, max = 0, total = 0;
+    for (i = 0; i < NWORK; i ++) {
+        assert(waitpid(pids[i], &done[i]) == 0);
+        total += done[i];
+        if (min < 0 || done[i] < min) {
+            min = done[i];
+        }
+        if (done[i] > max) {
+            max = done[i];
+        }
+    }
+    assert(total > 0);
+
+    int avg = total / NWORK;
+    cprintf("%d workers: completion min %d ms, avg %d ms, max %d ms\n", NWORK, min, avg, max);
+    cprintf("completion skew: %d%%\n", (max - min) * 100 / avg);
+    cprintf("balance pass.\n");
+    return 0;
+}
@@ -0,0 +1,77 @@
+#include <ulib.h>
+#include <stdio.h>
+
+/* *
+ * execbench - cost of starting a program from parents of various sizes
+ *
+ *   fork+exec   fork copies every page of the parent, exec throws it away
+ *   vfork+exec  the child borrows the parent's mm until the exec
+ *   spawn       the child is created with the new program loaded directly
+ *
+ * The parent dirties the first heap_kb of a static heap before each round,
+ * so fork has that much more to copy. The program run is "true", which
+ * exits at once. Times are per program started, waited for and reaped.
+ * */
+
+#define HEAP_SIZE   (4 * 1024 * 1024)
+#define NRUN        20
+
+static char heap[HEAP_SIZE];
+static const char *argv[] = {"true", NULL};
+
+static int
+run_fork_exec(void) {
+    int pid;
+    if ((pid = fork()) == 0) {
+        exec("true", argv);
+        exit(-1);
+    }
+    return pid;
+}
+
+static int
+run_vfork_exec(void) {
+    int pid;
+    // 子进程还在用父进程的栈，exec失败了只能直接退出
+    if ((pid = vfork()) == 0) {
+        exec("true", argv);
+        exit(-1);
+    }
+    return pid;
+}
+
+static int
+run_spawn(void) {
+    return spawn("true", argv);
+}
+
+// 平均每次的微秒数
+static unsigned int
+bench(int (*run)(void)) {
+    int i, pid, code;
+    unsigned int start = gettime_msec();
+    for (i = 0; i < NRUN; i ++) {
+        assert((pid = run()) > 0);
+        assert(waitpid(pid, &code) == 0 && code == 0);
+    }
+    return (gettime_msec() - start) * 1000 / NRUN;
+}
+
+int
+main(void) {
+    static const int sizes_kb[] = {0, 256, 1024, 4096};
+    int i, j;
+
+    cprintf("%8s %12s %12s %12s\n", "heap_kb", "fork+exec", "vfork+exec", "spawn");
+    for (i = 0; i < sizeof(sizes_kb) / sizeof(sizes_kb[0]); i ++) {
+        for (j = 0; j < sizes_kb[i] * 1024; j += 4096) {
+            heap[j] = 1;
+        }
+        unsigned int t_fork = bench(run_fork_exec);
+        unsigned int t_vfork = bench(run_vfork_exec);
+        unsigned int t_spawn = bench(run_spawn);
+        cprintf("%8d %10u us %10u us %10u us\n", sizes_kb[i], t_fork, t_vfork, t_spawn);
+    }
+    cprintf("execbench pass.\n");
+    return 0;
+}
@@ -0,0 +1,50 @@
+#include <ulib.h>
+#include <stdio.h>
+
+/* *
+ * forkstorm - fork latency with many processes alive
+ *
+ * Each round forks BATCH children which exit at once, then reaps them all,
+ * so up to BATCH zombies hold their pids while new ones are allocated.
+ * The time per fork shouldn't grow with the number of live processes.
+ * */
+
+#define ROUNDS      8
+#define BATCH       500
+
+int
+main(void) {
+    static int pids[BATCH];
+    unsigned int total_cycles = 0, total_forks = 0;
+    unsigned int start_msec = gettime_msec();
+    int r, i;
+
+    for (r = 0; r < ROUNDS; r ++) {
+        int n = 0;
+        uint64_t start = cycles();
+        for (i = 0; i < BATCH; i ++) {
+            if ((pids[i] = fork()) == 0) {
+                exit(0);
+            }
+            // 内存或者进程数不够了就少建几个
+            if (pids[i] < 0) {
+                break;
+            }
+            n ++;
+        }
+        unsigned int spent = (unsigned int)(cycles() - start);
+        assert(n > 0);
+        for (i = 0; i < n; i ++) {
+            assert(waitpid(pids[i], NULL) == 0);
+        }
+        cprintf("round %d: %d forks, %u cycles per fork\n", r, n, spent / n);
+        total_cycles += spent / n;
+        total_forks += n;
+    }
+
+    unsigned int msec = gettime_msec() - start_msec;
+    cprintf("%u forks reaped in %u ms, avg %u cycles per fork\n",
+            total_forks, msec, total_cycles / ROUNDS);
+    cprintf("forkstorm pass.\n");
+    return 0;
+}
@@ -0,0 +1,119 @@
+#include <ulib.h>
+#include <stdio.h>
+
+/* *
+ * futextest - mutex and condition variable on top of futex
+ *
+ *   uncontended  lock/unlock with one thread, no syscall at all
+ *   counter      NTHREAD threads bump a shared counter under the mutex,
+ *                yielding while holding it so that the others must sleep
+ *   queue        a producer hands NITEM items to consumers through a
+ *                one-slot queue guarded by a mutex and two condvars
+ * */
+
+#define NTHREAD     4
+#define STACK_SIZE  4096
+#define NLOOP       2000
+#define NLOCK       100000
+#define NITEM       1000
+
+static char stacks[NTHREAD][STACK_SIZE];
+
+static mutex_t mutex = MUTEX_INIT;
+static volatile int counter;
+
+static cond_t not_empty = COND_INIT, not_full = COND_INIT;
+static volatile int slot, full, consumed_sum;
+
+static int
+adder(void *arg) {
+    int i;
+    for (i = 0; i < NLOOP; i ++) {
+        mutex_lock(&mutex);
+        int c = counter;
+        // 持有锁的时候让出CPU，别的线程只能在futex里等
+        if (i % 100 == 0) {
+            yield();
+        }
+        counter = c + 1;
+        mutex_unlock(&mutex);
+    }
+    return 0;
+}
+
+static int
+consumer(void *arg) {
+    int n = 0;
+    while (1) {
+        mutex_lock(&mutex);
+        while (!full) {
+            cond_wait(&not_empty, &mutex);
+        }
+        int item = slot;
+        full = 0;
+        // item为0表示没有更多了
+        if (item != 0) {
+            consumed_sum += item;
+            cond_signal(&not_full);
+        }
+        else {
+            full = 1;
+            cond_broadcast(&not_empty);
+        }
+        mutex_unlock(&mutex);
+        if (item == 0) {
+            return n;
+        }
+        n ++;
+    }
+}
+
+static void
+produce(int item) {
+    mutex_lock(&mutex);
+    while (full) {
+        cond_wait(&not_full, &mutex);
+    }
+    slot = item, full = 1;
+    cond_signal(&not_empty);
+    mutex_unlock(&mutex);
+}
+
+int
+main(void) {
+    thread_t threads[NTHREAD];
+    int i, n, total;
+
+    uint64_t start = cycles();
+    for (i = 0; i < NLOCK; i ++) {
+        mutex_lock(&mutex);
+        mutex_unlock(&mutex);
+    }
+    cprintf("uncontended: %u cycles per lock/unlock\n",
+            (unsigned int)(cycles() - start) / NLOCK);
+
+    for (i = 0; i < NTHREAD; i ++) {
+        assert(thread_create(threads + i, adder, NULL, stacks[i], STACK_SIZE) == 0);
+    }
+    for (i = 0; i < NTHREAD; i ++) {
+        assert(thread_join(threads + i, NULL) == 0);
+    }
+    cprintf("counter: %d, expected %d\n", counter, NTHREAD * NLOOP);
+    assert(counter == NTHREAD * NLOOP);
+
+    for (i = 0; i < NTHREAD; i ++) {
+        assert(thread_create(threads + i, consumer, NULL, stacks[i], STACK_SIZE) == 0);
+    }
+    for (i = 1; i <= NITEM; i ++) {
+        produce(i);
+    }
+    produce(0);
+    for (i = 0, total = 0; i < NTHREAD; i ++) {
+        assert(thread_join(threads + i, &n) == 0);
+        cprintf("consumer %d took %d items\n", i, n);
+        total += n;
+    }
+    assert(total == NITEM && consumed_sum == NITEM * (NITEM + 1) / 2);
+    cprintf("futextest pass.\n");
+    return 0;
+}
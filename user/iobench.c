@@ -0,0 +1,111 @@
+#include <ulib.h>
+#include <stdio.h>
+#include <file.h>
+
+/* *
+ * iobench - file i/o throughput through the sfs, in KB/s
+ *
+ * A FILE_SIZE file is written and read back sequentially, then the same
+ * amount of data is read and written in blocks at random block aligned
+ * offsets, for each block size. The file is fsync'ed after the writes, so
+ * the write numbers include getting the data to the disk.
+ *
+ * sfs can't create files, so the file is put into the image by the makefile
+ * (IOBENCH_FILE_NBLOCKS), and only overwritten here.
+ * */
+
+#define FILE_NAME   "iobench.dat"
+#define FILE_SIZE   (1024 * 1024)   // 和makefile里的IOBENCH_FILE_NBLOCKS一致
+#define MAX_BLOCK   (32 * 1024)
+
+static char buf[MAX_BLOCK];
+static const unsigned int block_sizes[] = {512, 4096, MAX_BLOCK};
+
+static unsigned int seed = 1;
+
+// 简单的线性同余，够打乱偏移了
+static unsigned int
+next_rand(void) {
+    seed = seed * 1103515245 + 12345;
+    return seed >> 8;
+}
+
+// FILE_SIZE字节花了msec毫秒，换算成KB/s
+static unsigned int
+kb_per_sec(unsigned int msec) {
+    if (msec == 0) {
+        msec = 1;
+    }
+    return (FILE_SIZE / 1024) * 1000 / msec;
+}
+
+static unsigned int
+bench_seq(int fd, unsigned int bsize, bool do_write) {
+    unsigned int n, start = gettime_msec();
+    assert(seek(fd, 0, LSEEK_SET) == 0);
+    for (n = 0; n < FILE_SIZE; n += bsize) {
+        if (do_write) {
+            assert(write(fd, buf, bsize) == bsize);
+        } else {
+            assert(read(fd, buf, bsize) == bsize);
+        }
+    }
+    if (do_write) {
+        assert(fsync(fd) == 0);
+    }
+    return kb_per_sec(gettime_msec() - start);
+}
+
+static unsigned int
+bench_rand(int fd, unsigned int bsize, bool do_write) {
+    unsigned int n, nblock = FILE_SIZE / bsize, start = gettime_msec();
+    for (n = 0; n < nblock; n ++) {
+        assert(seek(fd, (next_rand() % nblock) * bsize, LSEEK_SET) == 0);
+        if (do_write) {
+            assert(write(fd, buf, bsize) == bsize);
+        } else {
+            assert(read(fd, buf, bsize) == bsize);
+        }
+    }
+    if (do_write) {
+        assert(fsync(fd) == 0);
+    }
+    return kb_per_sec(gettime_msec() - start);
+}
+
+int
+main(void) {
+    int fd, i;
+    struct stat stat;
+
+    if ((fd = open(FILE_NAME, O_RDWR)) < 0) {
+        panic("open %s failed: %e.\n", FILE_NAME, fd);
+    }
+    assert(fstat(fd, &stat) == 0 && stat.st_size == FILE_SIZE);
+    for (i = 0; i < MAX_BLOCK; i ++) {
+        buf[i] = (char)i;
+    }
+
+    cprintf("%8s %10s %10s %10s %10s\n", "block", "seq-write", "seq-read", "rand-read", "rand-write");
+    for (i = 0; i < sizeof(block_sizes) / sizeof(block_sizes[0]); i ++) {
+        unsigned int bsize = block_sizes[i];
+        unsigned int sw = bench_seq(fd, bsize, 1);
+        unsigned int sr = bench_seq(fd, bsize, 0);
+        unsigned int rr = bench_rand(fd, bsize, 0);
+        unsigned int rw = bench_rand(fd, bsize, 1);
+        cprintf("%8u %10u %10u %10u %10u\n", bsize, sw, sr, rr, rw);
+    }
+
+    // 写进去的数据要读得回来
+    assert(fstat(fd, &stat) == 0 && stat.st_size == FILE_SIZE);
+    assert(seek(fd, 0, LSEEK_SET) == 0);
+    assert(read(fd, buf, MAX_BLOCK) == MAX_BLOCK);
+    for (i = 0; i < MAX_BLOCK; i ++) {
+        assert(buf[i] == (char)i);
+    }
+
+    assert(close(fd) == 0);
+    cprintf("(KB/s, file size %d KB)\n", FILE_SIZE / 1024);
+    cprintf("iobench pass.\n");
+    return 0;
+}
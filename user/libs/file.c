@@ -0,0 +1,63 @@
+#include "libs/defs.h"
+#include "user/libs/syscall.h"
+#include "user/libs/file.h"
+
+// open - open or create a file, returns the fd or a negative error code
+int open(const char *path, uint32_t open_flags)
+{
+    return sys_open(path, open_flags);
+}
+
+int close(int fd)
+{
+    return sys_close(fd);
+}
+
+// read - read at most @len bytes, returns the number of bytes read, 0 at the end of file
+int read(int fd, void *base, size_t len)
+{
+    return sys_read(fd, base, len);
+}
+
+// write - write at most @len bytes, returns the number of bytes written
+int write(int fd, const void *base, size_t len)
+{
+    return sys_write(fd, base, len);
+}
+
+// seek - move the file position, @whence is one of LSEEK_SET, LSEEK_CUR and LSEEK_END
+int seek(int fd, off_t pos, int whence)
+{
+    return sys_seek(fd, pos, whence);
+}
+
+int fstat(int fd, struct stat *stat)
+{
+    return sys_fstat(fd, stat);
+}
+
+// fsync - write the dirty data of the file back to the disk
+int fsync(int fd)
+{
+    return sys_fsync(fd);
+}
+
+int getcwd(char *buf, size_t len)
+{
+    return sys_getcwd(buf, len);
+}
+
+/* *
+ * getdirentry - read the next entry of the directory @fd into @dirent,
+ * dirent->offset says which entry and is advanced by the kernel
+ * */
+int getdirentry(int fd, struct dirent *dirent)
+{
+    return sys_getdirentry(fd, dirent);
+}
+
+// dup2 - make @fd2 refer to the same open file as @fd1
+int dup2(int fd1, int fd2)
+{
+    return sys_dup(fd1, fd2);
+}
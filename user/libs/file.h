@@ -0,0 +1,20 @@
+#ifndef __USER_LIBS_FILE_H__
+#define __USER_LIBS_FILE_H__
+
+#include "libs/defs.h"
+#include "libs/unistd.h"
+#include "libs/stat.h"
+#include "libs/dirent.h"
+
+int open(const char *path, uint32_t open_flags);
+int close(int fd);
+int read(int fd, void *base, size_t len);
+int write(int fd, const void *base, size_t len);
+int seek(int fd, off_t pos, int whence);
+int fstat(int fd, struct stat *stat);
+int fsync(int fd);
+int getcwd(char *buf, size_t len);
+int getdirentry(int fd, struct dirent *dirent);
+int dup2(int fd1, int fd2);
+
+#endif // __USER_LIBS_FILE_H__
@@ -0,0 +1,97 @@
+#include "libs/defs.h"
+#include "libs/atomic.h"
+#include "libs/unistd.h"
+#include "user/libs/syscall.h"
+#include "user/libs/ulib.h"
+
+/* *
+ * 互斥锁和条件变量
+ *
+ * 没有竞争的时候加锁解锁都只是一条原子指令，不进内核。
+ * 加锁失败时把锁的值改成2再睡眠，解锁的人看到2才去唤醒等待的进程。
+ * */
+
+void mutex_init(mutex_t *mutex)
+{
+    mutex->val = 0;
+}
+
+void mutex_lock(mutex_t *mutex)
+{
+    int c = atomic_cmpxchg(&(mutex->val), 0, 1);
+    if (c == 0)
+    {
+        return;
+    }
+    // 标记有人在等，再睡到锁被释放，醒来以后仍然按有人在等的状态抢锁
+    if (c != 2)
+    {
+        c = atomic_xchg(&(mutex->val), 2);
+    }
+    while (c != 0)
+    {
+        sys_futex(&(mutex->val), FUTEX_WAIT, 2);
+        c = atomic_xchg(&(mutex->val), 2);
+    }
+}
+
+bool mutex_trylock(mutex_t *mutex)
+{
+    return atomic_cmpxchg(&(mutex->val), 0, 1) == 0;
+}
+
+void mutex_unlock(mutex_t *mutex)
+{
+    if (atomic_xchg(&(mutex->val), 0) == 2)
+    {
+        sys_futex(&(mutex->val), FUTEX_WAKE, 1);
+    }
+}
+
+void cond_init(cond_t *cond)
+{
+    cond->seq = 0;
+    cond->waiters = 0;
+}
+
+/* *
+ * cond_wait - release @mutex and sleep until @cond is signaled, then take the
+ * mutex again. Wakeups may be spurious, so the caller checks its condition in
+ * a loop. The seq read under the mutex makes a signal sent after the unlock
+ * but before the sleep turn the futex wait into an immediate return.
+ * */
+void cond_wait(cond_t *cond, mutex_t *mutex)
+{
+    int seq = cond->seq;
+    cond->waiters++;
+    mutex_unlock(mutex);
+    sys_futex(&(cond->seq), FUTEX_WAIT, seq);
+    // 可能还有别的进程被一起唤醒，按有人在等的状态加锁，解锁时才会接着唤醒它们
+    while (atomic_xchg(&(mutex->val), 2) != 0)
+    {
+        sys_futex(&(mutex->val), FUTEX_WAIT, 2);
+    }
+    cond->waiters--;
+}
+
+// cond_signal - wake up one waiter, no syscall if nobody waits; call it with the mutex held
+void cond_signal(cond_t *cond)
+{
+    if (cond->waiters == 0)
+    {
+        return;
+    }
+    atomic_add(&(cond->seq), 1);
+    sys_futex(&(cond->seq), FUTEX_WAKE, 1);
+}
+
+// cond_broadcast - wake up all the waiters, no syscall if nobody waits; call it with the mutex held
+void cond_broadcast(cond_t *cond)
+{
+    if (cond->waiters == 0)
+    {
+        return;
+    }
+    atomic_add(&(cond->seq), 1);
+    sys_futex(&(cond->seq), FUTEX_WAKE, cond->waiters);
+}
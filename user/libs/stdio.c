@@ -1,18 +1,65 @@
 #include "libs/defs.h"
 #include "user/libs/syscall.h"
 #include "user/libs/stdio.h"
+#include "user/libs/ulib.h"
+
+#define STDOUT_FD 1
+#define STDOUT_BUFSIZE 1024
+
+// 标准输出的缓冲区，同一个进程的线程共用，用锁保护
+static char stdout_buf[STDOUT_BUFSIZE];
+static size_t stdout_len;
+static mutex_t stdout_mutex = MUTEX_INIT;
+
+// 把缓冲区里的字符写出去，调用时需要持有stdout_mutex
+static void
+stdout_flush(void)
+{
+    size_t off = 0;
+    while (off < stdout_len)
+    {
+        int ret = sys_write(STDOUT_FD, stdout_buf + off, stdout_len - off);
+        if (ret <= 0)
+        {
+            // 没有打开标准输出，只能一个字符一个字符地输出
+            for (; off < stdout_len; off++)
+            {
+                sys_putc(stdout_buf[off]);
+            }
+            break;
+        }
+        off += ret;
+    }
+    stdout_len = 0;
+}
 
 /* *
  * cputch - writes a single character @c to stdout, and it will
- * increace the value of counter pointed by @cnt.
+ * increace the value of counter pointed by @cnt. The characters are
+ * buffered until a newline or the buffer is full.
  * */
 static void
 cputch(int c, int *cnt)
 {
-    sys_putc(c);
+    stdout_buf[stdout_len++] = c;
+    if (c == '\n' || stdout_len == STDOUT_BUFSIZE)
+    {
+        stdout_flush();
+    }
     (*cnt)++;
 }
 
+/* *
+ * cflush - write out what is left in the stdout buffer. It must be called
+ * before exit, exec and fork, or the output is lost or printed twice.
+ * */
+void cflush(void)
+{
+    mutex_lock(&stdout_mutex);
+    stdout_flush();
+    mutex_unlock(&stdout_mutex);
+}
+
 /* *
  * vcprintf - format a string and writes it to stdout
  *
@@ -25,7 +72,9 @@ cputch(int c, int *cnt)
 int vcprintf(const char *fmt, va_list ap)
 {
     int cnt = 0;
+    mutex_lock(&stdout_mutex);
     vprintfmt((void *)cputch, &cnt, fmt, ap);
+    mutex_unlock(&stdout_mutex);
     return cnt;
 }
 
@@ -54,10 +103,12 @@ int cputs(const char *str)
 {
     int cnt = 0;
     char c;
+    mutex_lock(&stdout_mutex);
     while ((c = *str++) != '\0')
     {
         cputch(c, &cnt);
     }
     cputch('\n', &cnt);
+    mutex_unlock(&stdout_mutex);
     return cnt;
 }
@@ -7,6 +7,7 @@
 int cprintf(const char *fmt, ...);
 int vcprintf(const char *fmt, va_list ap);
 int cputs(const char *str);
+void cflush(void);
 
 void printfmt(void (*putch)(int, void *), void *putdat, const char *fmt, ...);
 void vprintfmt(void (*putch)(int, void *), void *putdat, const char *fmt, va_list ap);
@@ -2,9 +2,13 @@
 #include "libs/defs.h"
 #include "libs/unistd.h"
 #include "libs/stdarg.h"
+#include "libs/x86.h"
 
 #define MAX_ARGS 5
 
+// 启动时检查CPU，支持的话系统调用走sysenter，否则走int 0x80
+static bool use_sysenter;
+
 static inline int
 syscall(int num, ...)
 {
@@ -18,6 +22,25 @@ syscall(int num, ...)
     }
     va_end(ap);
 
+    if (use_sysenter)
+    {
+        // 内核从ebp指向的用户栈上取回返回地址，sysexit时edx和ecx会被覆盖
+        uint32_t d = a[0], c = a[1];
+        asm volatile(
+            "pushl %%ebp;"
+            "pushl $1f;"
+            "movl %%esp, %%ebp;"
+            "sysenter;"
+            "1: popl %%ebp;"
+            : "=a"(ret), "+d"(d), "+c"(c)
+            : "0"(num),
+              "b"(a[2]),
+              "D"(a[3]),
+              "S"(a[4])
+            : "cc", "memory");
+        return ret;
+    }
+
     asm volatile(
         "int %1;"
         : "=a"(ret)
@@ -32,6 +55,27 @@ syscall(int num, ...)
     return ret;
 }
 
+/* *
+ * syscall_init - pick the system call instruction, called once before main.
+ * sysenter is used if the cpu supports it, int 0x80 otherwise.
+ * */
+void syscall_init(void)
+{
+    use_sysenter = cpu_has_sysenter();
+}
+
+/* *
+ * syscall_set_sysenter - switch between sysenter (@on != 0) and int 0x80,
+ * returns the previous setting. sysenter is only turned on if the cpu
+ * supports it. Used by the benchmarks to compare the two paths.
+ * */
+bool syscall_set_sysenter(bool on)
+{
+    bool old = use_sysenter;
+    use_sysenter = on && cpu_has_sysenter();
+    return old;
+}
+
 int sys_exit(int error_code)
 {
     return syscall(SYS_exit, error_code);
@@ -42,6 +86,52 @@ int sys_fork(void)
     return syscall(SYS_fork);
 }
 
+int sys_exec(const char *name, int argc, const char **argv)
+{
+    return syscall(SYS_exec, name, argc, argv);
+}
+
+int sys_spawn(const char *name, int argc, const char **argv)
+{
+    return syscall(SYS_spawn, name, argc, argv);
+}
+
+int sys_exit_thread(int error_code)
+{
+    return syscall(SYS_exit_thread, error_code);
+}
+
+/* *
+ * sys_clone - create a child running on @stack which calls fn(arg) and exits
+ * with its return value. The child starts with the registers of the parent,
+ * so it must not return from here: the call is done in the same asm block,
+ * before anything is read from the parent's stack.
+ * */
+int sys_clone(uint32_t clone_flags, uintptr_t stack, int (*fn)(void *), void *arg)
+{
+    int ret;
+    asm volatile(
+        "int %1;"
+        "testl %%eax, %%eax;"
+        "jnz 1f;"
+        "pushl %%esi;"
+        "call *%%edi;"
+        "movl %%eax, %%edx;"
+        "movl %2, %%eax;"
+        "int %1;"
+        "1:"
+        : "=a"(ret)
+        : "i"(T_SYSCALL),
+          "i"(SYS_exit_thread),
+          "a"(SYS_clone),
+          "d"(clone_flags),
+          "c"(stack),
+          "D"(fn),
+          "S"(arg)
+        : "cc", "memory");
+    return ret;
+}
+
 int sys_wait(int pid, int *store)
 {
     return syscall(SYS_wait, pid, store);
@@ -52,6 +142,11 @@ int sys_yield(void)
     return syscall(SYS_yield);
 }
 
+int sys_sleep(unsigned int time)
+{
+    return syscall(SYS_sleep, time);
+}
+
 int sys_kill(int pid)
 {
     return syscall(SYS_kill, pid);
@@ -71,3 +166,103 @@ int sys_pgdir(void)
 {
     return syscall(SYS_pgdir);
 }
+
+int sys_gettime(void)
+{
+    return syscall(SYS_gettime);
+}
+
+int sys_swapstat(struct swapstat *stat)
+{
+    return syscall(SYS_swapstat, stat);
+}
+
+int sys_setdeadline(unsigned int runtime, unsigned int deadline, unsigned int period)
+{
+    return syscall(SYS_setdeadline, runtime, deadline, period);
+}
+
+int sys_setpriority(int pid, int priority)
+{
+    return syscall(SYS_setpriority, pid, priority);
+}
+
+int sys_getpriority(int pid)
+{
+    return syscall(SYS_getpriority, pid);
+}
+
+int sys_schedstat(int pid, struct schedstat *stat)
+{
+    return syscall(SYS_schedstat, pid, stat);
+}
+
+int sys_sched_setaffinity(int pid, unsigned int mask)
+{
+    return syscall(SYS_sched_setaffinity, pid, mask);
+}
+
+int sys_sched_getaffinity(int pid, unsigned int *mask)
+{
+    return syscall(SYS_sched_getaffinity, pid, mask);
+}
+
+int sys_futex(volatile int *addr, int op, int val)
+{
+    return syscall(SYS_futex, addr, op, val);
+}
+
+int sys_getrusage(int who, struct rusage *usage)
+{
+    return syscall(SYS_getrusage, who, usage);
+}
+
+int sys_open(const char *path, uint32_t open_flags)
+{
+    return syscall(SYS_open, path, open_flags);
+}
+
+int sys_close(int fd)
+{
+    return syscall(SYS_close, fd);
+}
+
+int sys_read(int fd, void *base, size_t len)
+{
+    return syscall(SYS_read, fd, base, len);
+}
+
+int sys_write(int fd, const void *base, size_t len)
+{
+    return syscall(SYS_write, fd, base, len);
+}
+
+int sys_seek(int fd, off_t pos, int whence)
+{
+    return syscall(SYS_seek, fd, pos, whence);
+}
+
+int sys_fstat(int fd, struct stat *stat)
+{
+    return syscall(SYS_fstat, fd, stat);
+}
+
+int sys_fsync(int fd)
+{
+    return syscall(SYS_fsync, fd);
+}
+
+int sys_getcwd(char *buf, size_t len)
+{
+    return syscall(SYS_getcwd, buf, len);
+}
+
+int sys_getdirentry(int fd, struct dirent *dirent)
+{
+    return syscall(SYS_getdirentry, fd, dirent);
+}
+
+int sys_dup(int fd1, int fd2)
+{
+    return syscall(SYS_dup, fd1, fd2);
+}
@@ -1,14 +1,48 @@
 #ifndef __USER_LIBS_SYSCALL_H__
 #define __USER_LIBS_SYSCALL_H__
 
+#include "libs/swapstat.h"
+#include "libs/schedstat.h"
+#include "libs/rusage.h"
+#include "libs/stat.h"
+#include "libs/dirent.h"
+
+void syscall_init(void);
+bool syscall_set_sysenter(bool on);
+
 int sys_exit(int error_code);
 int sys_fork(void);
+int sys_exec(const char *name, int argc, const char **argv);
+int sys_spawn(const char *name, int argc, const char **argv);
+int sys_exit_thread(int error_code);
+int sys_clone(uint32_t clone_flags, uintptr_t stack, int (*fn)(void *), void *arg);
 int sys_wait(int pid, int *store);
 int sys_yield(void);
+int sys_sleep(unsigned int time);
 int sys_kill(int pid);
 int sys_getpid(void);
 int sys_putc(int c);
 int sys_pgdir(void);
+int sys_gettime(void);
+int sys_swapstat(struct swapstat *stat);
+int sys_setdeadline(unsigned int runtime, unsigned int deadline, unsigned int period);
+int sys_setpriority(int pid, int priority);
+int sys_getpriority(int pid);
+int sys_schedstat(int pid, struct schedstat *stat);
+int sys_sched_setaffinity(int pid, unsigned int mask);
+int sys_sched_getaffinity(int pid, unsigned int *mask);
+int sys_futex(volatile int *addr, int op, int val);
+int sys_getrusage(int who, struct rusage *usage);
+int sys_open(const char *path, uint32_t open_flags);
+int sys_close(int fd);
+int sys_read(int fd, void *base, size_t len);
+int sys_write(int fd, const void *base, size_t len);
+int sys_seek(int fd, off_t pos, int whence);
+int sys_fstat(int fd, struct stat *stat);
+int sys_fsync(int fd);
+int sys_getcwd(char *buf, size_t len);
+int sys_getdirentry(int fd, struct dirent *dirent);
+int sys_dup(int fd1, int fd2);
 
 #endif /* !__USER_LIBS_SYSCALL_H__ */
 
@@ -2,9 +2,12 @@
 #include "user/libs/syscall.h"
 #include "user/libs/stdio.h"
 #include "user/libs/ulib.h"
+#include "libs/x86.h"
+#include "libs/unistd.h"
 
 void exit(int error_code)
 {
+    cflush();
     sys_exit(error_code);
     cprintf("BUG: exit failed.\n");
     while (1)
@@ -13,6 +16,8 @@ void exit(int error_code)
 
 int fork(void)
 {
+    // 不然缓冲区里没输出的字符父子进程会各输出一遍
+    cflush();
     return sys_fork();
 }
 
@@ -36,6 +41,12 @@ int kill(int pid)
     return sys_kill(pid);
 }
 
+// sleep - sleep for @time ticks without consuming CPU
+int sleep(unsigned int time)
+{
+    return sys_sleep(time);
+}
+
 int getpid(void)
 {
     return sys_getpid();
@@ -46,3 +57,134 @@ void print_pgdir(void)
 {
     sys_pgdir();
 }
+
+// argv以NULL结尾
+static int argv_count(const char **argv)
+{
+    int argc = 0;
+    while (argv[argc] != NULL)
+    {
+        argc++;
+    }
+    return argc;
+}
+
+// exec - replace current program with the one at argv[0], named @name; on failure current process exits
+int exec(const char *name, const char **argv)
+{
+    cflush();
+    return sys_exec(name, argv_count(argv), argv);
+}
+
+// spawn - start the program at argv[0] in a new child process, return the pid of the child
+int spawn(const char *name, const char **argv)
+{
+    cflush();
+    return sys_spawn(name, argv_count(argv), argv);
+}
+
+// gettime_msec - get the time since boot in milliseconds, in the resolution of a tick
+unsigned int gettime_msec(void)
+{
+    return (unsigned int)sys_gettime() * 10;
+}
+
+// cycles - read the time stamp counter, for measuring short intervals
+uint64_t cycles(void)
+{
+    return rdtsc();
+}
+
+// use_sysenter - make system calls with sysenter (if supported) or int 0x80, returns the old setting
+bool use_sysenter(bool on)
+{
+    return syscall_set_sysenter(on);
+}
+
+// swapstat - get the swap statistics of current process and the whole system
+int swapstat(struct swapstat *stat)
+{
+    return sys_swapstat(stat);
+}
+
+/* *
+ * setdeadline - make current process a real-time process that runs @runtime
+ * ticks in every @period ticks, finishing within @deadline ticks from the
+ * start of each period. Returns -E_BUSY if the CPU can't guarantee that,
+ * and @period = 0 makes it a normal process again.
+ * */
+int setdeadline(unsigned int runtime, unsigned int deadline, unsigned int period)
+{
+    return sys_setdeadline(runtime, deadline, period);
+}
+
+// setpriority - set the stride weight of process @pid (0 for current), 1 ~ PRIORITY_MAX
+int setpriority(int pid, int priority)
+{
+    return sys_setpriority(pid, priority);
+}
+
+int getpriority(int pid)
+{
+    return sys_getpriority(pid);
+}
+
+// schedstat - get the scheduling statistics of process @pid (0 for current)
+int schedstat(int pid, struct schedstat *stat)
+{
+    return sys_schedstat(pid, stat);
+}
+
+// sched_setaffinity - let process @pid (0 for current) run only on the CPUs in @mask, bit i for cpu i
+int sched_setaffinity(int pid, unsigned int mask)
+{
+    return sys_sched_setaffinity(pid, mask);
+}
+
+// sched_getaffinity - get the online CPUs which process @pid (0 for current) may run on
+int sched_getaffinity(int pid, unsigned int *mask)
+{
+    return sys_sched_getaffinity(pid, mask);
+}
+
+/* *
+ * getrusage - get the resource usage of current process (RUSAGE_SELF), or
+ * the sum over its reaped children and their descendants (RUSAGE_CHILDREN)
+ * */
+int getrusage(int who, struct rusage *usage)
+{
+    return sys_getrusage(who, usage);
+}
+
+/* *
+ * thread_create - start a thread running fn(arg) on the @size bytes of
+ * @stack, sharing the address space and files of current process. The
+ * stack belongs to the caller and must stay valid until the thread is joined.
+ * */
+int thread_create(thread_t *thread, int (*fn)(void *), void *arg, void *stack, size_t size)
+{
+    // 栈顶按16字节对齐
+    uintptr_t top = ((uintptr_t)stack + size) & ~0xF;
+    int ret = sys_clone(CLONE_VM | CLONE_THREAD, top, fn, arg);
+    if (ret > 0)
+    {
+        thread->tid = ret;
+        ret = 0;
+    }
+    return ret;
+}
+
+// thread_join - wait for @thread to exit, only the process which created it can join it
+int thread_join(thread_t *thread, int *exit_code)
+{
+    return sys_wait(thread->tid, exit_code);
+}
+
+// thread_exit - exit current thread only, while exit() ends all the threads
+void thread_exit(int exit_code)
+{
+    sys_exit_thread(exit_code);
+    cprintf("BUG: thread_exit failed.\n");
+    while (1)
+        ;
+}
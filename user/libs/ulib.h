@@ -2,6 +2,9 @@
 #define __USER_LIBS_ULIB_H__
 
 #include "libs/defs.h"
+#include "libs/swapstat.h"
+#include "libs/schedstat.h"
+#include "libs/rusage.h"
 
 void __warn(const char *file, int line, const char *fmt, ...);
 void __panic(const char *file, int line, const char *fmt, ...);
@@ -31,11 +34,61 @@ void __panic(const char *file, int line, const char *fmt, ...);
 
 void exit(int error_code);
 int fork(void);
+int vfork(void) __attribute__((returns_twice));
 int wait(void);
 int waitpid(int pid, int *store);
+int exec(const char *name, const char **argv);
+int spawn(const char *name, const char **argv);
 void yield(void);
 int kill(int pid);
+int sleep(unsigned int time);
 int getpid(void);
 void print_pgdir(void);
+unsigned int gettime_msec(void);
+uint64_t cycles(void);
+bool use_sysenter(bool on);
+int swapstat(struct swapstat *stat);
+int setdeadline(unsigned int runtime, unsigned int deadline, unsigned int period);
+int setpriority(int pid, int priority);
+int getpriority(int pid);
+int schedstat(int pid, struct schedstat *stat);
+int sched_setaffinity(int pid, unsigned int mask);
+int sched_getaffinity(int pid, unsigned int *mask);
+int getrusage(int who, struct rusage *usage);
+
+// 和创建它的进程共享虚拟空间和打开文件的线程
+typedef struct
+{
+    int tid;
+} thread_t;
+
+int thread_create(thread_t *thread, int (*fn)(void *), void *arg, void *stack, size_t size);
+int thread_join(thread_t *thread, int *exit_code);
+void thread_exit(int exit_code) __attribute__((noreturn));
+
+// 基于futex的互斥锁，0没有锁住，1锁住了，2锁住了并且可能有人在等
+typedef struct
+{
+    volatile int val;
+} mutex_t;
+
+// 条件变量，每次signal或者broadcast都让seq加一
+typedef struct
+{
+    volatile int seq;
+    volatile int waiters;
+} cond_t;
+
+#define MUTEX_INIT {0}
+#define COND_INIT {0, 0}
+
+void mutex_init(mutex_t *mutex);
+void mutex_lock(mutex_t *mutex);
+bool mutex_trylock(mutex_t *mutex);
+void mutex_unlock(mutex_t *mutex);
+void cond_init(cond_t *cond);
+void cond_wait(cond_t *cond, mutex_t *mutex);
+void cond_signal(cond_t *cond);
+void cond_broadcast(cond_t *cond);
 
 #endif /* !__USER_LIBS_ULIB_H__ */
@@ -1,11 +1,38 @@
 #include "user/libs/ulib.h"
 #include "user/libs/stdio.h"
+#include "user/libs/syscall.h"
+#include "user/libs/file.h"
 
 int main(void);
 
+// 打开path并放到文件描述符fd上
+static int
+initfd(int fd, const char *path, uint32_t open_flags)
+{
+    int fd1, ret = 0;
+    if ((fd1 = open(path, open_flags)) < 0)
+    {
+        return fd1;
+    }
+    if (fd1 != fd)
+    {
+        close(fd);
+        ret = dup2(fd1, fd);
+        close(fd1);
+    }
+    return ret < 0 ? ret : 0;
+}
+
 void umain(void)
 {
+    syscall_init();
+    // exec会关掉所有打开的文件，cprintf要通过1号文件输出
+    int ret;
+    if ((ret = initfd(1, "stdout:", O_WRONLY)) != 0)
+    {
+        warn("open <stdout> failed: %e.\n", ret);
+    }
     cprintf("user start\n");
-    int ret = main();
+    ret = main();
     exit(ret);
 }
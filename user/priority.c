@@ -0,0 +1,58 @@
+#include <ulib.h>
+#include <stdio.h>
+
+/* *
+ * priority - CPU share of processes with different priorities
+ *
+ * Child i spins at priority i + 1 for RUN_MSEC, then the parent reads the
+ * scheduling statistics of every child before reaping it. Under the stride
+ * scheduler the ticks each child got should be proportional to its priority.
+ * */
+
+#define NSPIN       4
+#define RUN_MSEC    4000
+
+int
+main(void) {
+    int pids[NSPIN], i;
+    unsigned int end = gettime_msec() + RUN_MSEC;
+
+    assert(setpriority(0, 0) != 0);
+    assert(setpriority(0, NSPIN + 1) == 0);
+    for (i = 0; i < NSPIN; i ++) {
+        if ((pids[i] = fork()) == 0) {
+            assert(getpriority(0) == NSPIN + 1);
+            assert(setpriority(0, i + 1) == 0);
+            while (gettime_msec() < end) {
+                ;
+            }
+            // 等父进程读完统计信息
+            sleep(100);
+            exit(0);
+        }
+        assert(pids[i] > 0);
+    }
+
+    // 父进程只负责统计，不跟子进程抢CPU
+    sleep(RUN_MSEC / 10 + 10);
+
+    struct schedstat stats[NSPIN];
+    int total = 0;
+    for (i = 0; i < NSPIN; i ++) {
+        assert(schedstat(pids[i], &stats[i]) == 0);
+        total += stats[i].sc_run_ticks;
+    }
+    assert(total > 0);
+
+    for (i = 0; i < NSPIN; i ++) {
+        struct schedstat *s = &stats[i];
+        cprintf("pid %d priority %d: share %d%%, runs %d, run %d ticks, wait %d ticks, switches %d/%d (vol/invol)\n",
+                pids[i], getpriority(pids[i]), s->sc_run_ticks * 100 / total, s->sc_runs,
+                s->sc_run_ticks, s->sc_wait_ticks, s->sc_nvcsw, s->sc_nivcsw);
+    }
+    for (i = 0; i < NSPIN; i ++) {
+        assert(waitpid(pids[i], NULL) == 0);
+    }
+    cprintf("priority pass.\n");
+    return 0;
+}
@@ -0,0 +1,61 @@
+#include <ulib.h>
+#include <stdio.h>
+
+/* *
+ * rtdemo - a real-time process next to cpu-bound normal processes
+ *
+ * The real-time process asks for RUNTIME ticks in every PERIOD ticks and
+ * records when it gets the CPU in each period. The normal processes just
+ * spin; they must not delay the real-time process past its deadlines.
+ * */
+
+#define NSPIN       2
+#define RUNTIME     2
+#define PERIOD      10
+#define NPERIODS    20
+
+static void
+spin(void) {
+    while (1) {
+        ;
+    }
+}
+
+int
+main(void) {
+    int pids[NSPIN], i;
+    for (i = 0; i < NSPIN; i ++) {
+        if ((pids[i] = fork()) == 0) {
+            spin();
+        }
+        assert(pids[i] > 0);
+    }
+
+    // 占用率超过上限的申请会被拒绝
+    assert(setdeadline(PERIOD, PERIOD, PERIOD) != 0);
+    assert(setdeadline(RUNTIME, PERIOD, PERIOD) == 0);
+
+    // 每个周期开始时醒来一次，检查是否在截止时间之前拿到了CPU
+    int missed = 0, lat_max = 0;
+    for (i = 0; i < NPERIODS; i ++) {
+        unsigned int start = gettime_msec();
+        sleep(PERIOD - 1);
+        int lat = gettime_msec() - start - (PERIOD - 1) * 10;
+        if (lat >= 10) {
+            missed ++;
+        }
+        if (lat > lat_max) {
+            lat_max = lat;
+        }
+    }
+    assert(setdeadline(0, 0, 0) == 0);
+
+    for (i = 0; i < NSPIN; i ++) {
+        assert(kill(pids[i]) == 0);
+        assert(waitpid(pids[i], NULL) == 0);
+    }
+    cprintf("rtdemo: %d periods, %d late wakeups, max latency %d ms\n", NPERIODS, missed, lat_max);
+    assert(missed == 0);
+    cprintf("rtdemo pass.\n");
+    return 0;
+}
@@ -0,0 +1,68 @@
+#include <ulib.h>
+#include <stdio.h>
+
+/* *
+ * rusage - per-process cpu time and resource usage
+ *
+ * The parent spins in user mode, then in syscalls, and checks that the
+ * ticks landed in ru_utime and ru_stime. A child touches a fresh heap
+ * and exits, and its page faults and times must show up in the parent's
+ * RUSAGE_CHILDREN totals once it has been reaped, not before.
+ * */
+
+#define SPIN_MSEC   500
+#define HEAP_SIZE   (1024 * 1024)
+
+static char heap[HEAP_SIZE];
+
+static void
+print_rusage(const char *name, struct rusage *ru) {
+    cprintf("%s: utime %u stime %u ticks, nvcsw %u nivcsw %u, minflt %u majflt %u\n",
+            name, ru->ru_utime, ru->ru_stime, ru->ru_nvcsw, ru->ru_nivcsw,
+            ru->ru_minflt, ru->ru_majflt);
+}
+
+int
+main(void) {
+    struct rusage before, after, children;
+    int pid, i;
+
+    assert(getrusage(RUSAGE_SELF, &before) == 0);
+    unsigned int end = gettime_msec() + SPIN_MSEC;
+    while (gettime_msec() < end) {
+        for (i = 0; i < 10000; i ++) {
+            __asm__ __volatile__("" ::: "memory");
+        }
+    }
+    end = gettime_msec() + SPIN_MSEC;
+    while (gettime_msec() < end) {
+        getpid();
+    }
+    assert(getrusage(RUSAGE_SELF, &after) == 0);
+    print_rusage("self", &after);
+    assert(after.ru_utime > before.ru_utime && after.ru_stime > before.ru_stime);
+
+    assert(getrusage(RUSAGE_CHILDREN, &children) == 0);
+    size_t minflt = children.ru_minflt;
+    if ((pid = fork()) == 0) {
+        for (i = 0; i < HEAP_SIZE; i += 4096) {
+            heap[i] = 1;
+        }
+        end = gettime_msec() + SPIN_MSEC;
+        while (gettime_msec() < end) {
+            yield();
+        }
+        exit(0);
+    }
+    assert(pid > 0);
+    // 子进程还没被回收，不算在里面
+    assert(getrusage(RUSAGE_CHILDREN, &children) == 0 && children.ru_minflt == minflt);
+    assert(waitpid(pid, NULL) == 0);
+    assert(getrusage(RUSAGE_CHILDREN, &children) == 0);
+    print_rusage("children", &children);
+    assert(children.ru_minflt > minflt && children.ru_nivcsw > 0);
+
+    assert(getrusage(1, &children) != 0);
+    cprintf("rusage pass.\n");
+    return 0;
+}
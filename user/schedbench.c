@@ -0,0 +1,79 @@
+#include <ulib.h>
+#include <stdio.h>
+
+/* *
+ * schedbench - fairness and wakeup latency of the scheduler
+ *
+ * NSPIN children spin for RUN_MSEC and report how many loops they got
+ * through, so their CPU share can be compared. Meanwhile the parent
+ * repeatedly forks a child that exits at once and measures how long it
+ * takes to run again after being woken up by the exiting child.
+ * */
+
+#define NSPIN       4
+#define RUN_MSEC    3000
+#define NWAKE       20
+
+static int
+spin(unsigned int end) {
+    volatile unsigned int loops = 0;
+    while (gettime_msec() < end) {
+        int i;
+        for (i = 0; i < 1000; i ++) {
+            loops ++;
+        }
+    }
+    // 以千次为单位作为退出码返回
+    return loops / 1000;
+}
+
+int
+main(void) {
+    int pids[NSPIN], loops[NSPIN];
+    unsigned int end = gettime_msec() + RUN_MSEC;
+    int i, pid;
+
+    for (i = 0; i < NSPIN; i ++) {
+        if ((pids[i] = fork()) == 0) {
+            exit(spin(end));
+        }
+        assert(pids[i] > 0);
+    }
+
+    // 子进程退出时记下时间，父进程从wait里醒来后算出延迟
+    unsigned int lat_max = 0, lat_sum = 0;
+    for (i = 0; i < NWAKE; i ++) {
+        if ((pid = fork()) == 0) {
+            exit(gettime_msec());
+        }
+        assert(pid > 0);
+        int exit_time;
+        assert(waitpid(pid, &exit_time) == 0);
+        unsigned int lat = gettime_msec() - exit_time;
+        lat_sum += lat;
+        if (lat > lat_max) {
+            lat_max = lat;
+        }
+    }
+
+    int total = 0, min = -1, max = 0;
+    for (i = 0; i < NSPIN; i ++) {
+        assert(waitpid(pids[i], &loops[i]) == 0);
+        total += loops[i];
+        if (min < 0 || loops[i] < min) {
+            min = loops[i];
+        }
+        if (loops[i] > max) {
+            max = loops[i];
+        }
+    }
+    assert(total > 0);
+
+    for (i = 0; i < NSPIN; i ++) {
+        cprintf("spinner %d: %d kloops, share %d%%\n", pids[i], loops[i], loops[i] * 100 / total);
+    }
+    cprintf("fairness: min/max = %d%%\n", min * 100 / max);
+    cprintf("wakeup latency: avg %d ms, max %d ms over %d wakeups\n", lat_sum / NWAKE, lat_max, NWAKE);
+    cprintf("schedbench pass.\n");
+    return 0;
+}
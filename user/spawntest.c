@@ -0,0 +1,37 @@
+#include <ulib.h>
+#include <stdio.h>
+
+/* *
+ * spawntest - start programs with spawn instead of fork+exec
+ *
+ * A missing program must be reported to the parent, and the spawned
+ * children must run and exit normally. The parent dirties a large heap first,
+ * which spawn doesn't copy, so the time per spawn shouldn't depend on it.
+ * */
+
+#define HEAP_SIZE   (4 * 1024 * 1024)
+#define NSPAWN      20
+
+static char heap[HEAP_SIZE];
+
+int
+main(void) {
+    int i, pid, code;
+    for (i = 0; i < HEAP_SIZE; i += 4096) {
+        heap[i] = (char)i;
+    }
+
+    const char *missing[] = {"no_such_program", NULL};
+    assert(spawn("missing", missing) < 0);
+
+    const char *argv[] = {"hello", "from", "spawntest", NULL};
+    unsigned int start = gettime_msec();
+    for (i = 0; i < NSPAWN; i ++) {
+        assert((pid = spawn("hello", argv)) > 0);
+        assert(waitpid(pid, &code) == 0 && code == 0);
+    }
+    cprintf("%d spawns with a %d KB heap in %u ms\n",
+            NSPAWN, HEAP_SIZE / 1024, gettime_msec() - start);
+    cprintf("spawntest pass.\n");
+    return 0;
+}
@@ -0,0 +1,30 @@
+#include <ulib.h>
+#include <stdio.h>
+#include <file.h>
+#include "libs/error.h"
+
+/* *
+ * swapfile - the active swap file can't be opened for writing
+ *
+ * swapfs reads and writes the blocks of the swap file directly, so writing
+ * or truncating it through the sfs would corrupt the swapped out pages and
+ * give its blocks back to the sfs. Opening it read-only is still allowed.
+ * */
+
+#define SWAP_FILE   "swap"
+
+int
+main(void) {
+    int fd;
+    if ((fd = open(SWAP_FILE, O_RDONLY)) < 0) {
+        cprintf("no swap file: %e, skipped.\n", fd);
+        return 0;
+    }
+    assert(close(fd) == 0);
+
+    assert(open(SWAP_FILE, O_WRONLY) == -E_BUSY);
+    assert(open(SWAP_FILE, O_RDWR) == -E_BUSY);
+    assert(open(SWAP_FILE, O_RDWR | O_TRUNC) == -E_BUSY);
+    cprintf("swapfile pass.\n");
+    return 0;
+}
@@ -0,0 +1,110 @@
+#include <ulib.h>
+#include <stdio.h>
+#include "libs/x86.h"
+
+/* *
+ * switchbench - cost of context switches, in tsc cycles
+ *
+ * Everything runs pinned to one CPU, so the numbers are switches and not
+ * cross-CPU wakeups:
+ *   yield-self   yield with nothing else runnable, the syscall and schedule()
+ *                without a switch
+ *   yield-pong   two processes yielding to each other, one switch per yield
+ *   wait-wakeup  two long-lived threads hand a token back and forth through
+ *                a condition variable, each handoff wakes up the sleeping
+ *                thread and puts the current one to sleep in the futex
+ * */
+
+#define NYIELD      20000
+#define NWAIT       5000
+#define STACK_SIZE  4096
+
+static char pong_stack[STACK_SIZE];
+static mutex_t pong_mutex = MUTEX_INIT;
+static cond_t pong_cond[2] = {COND_INIT, COND_INIT};
+static volatile int turn;
+
+// 平均每次的周期数，总周期数可能超过32位，在64位里做除法
+static unsigned int
+per_op(uint64_t total, unsigned int n) {
+    do_div(total, n);
+    return (unsigned int)total;
+}
+
+static unsigned int
+bench_yield_self(void) {
+    int i;
+    uint64_t start = cycles();
+    for (i = 0; i < NYIELD; i ++) {
+        yield();
+    }
+    return per_op(cycles() - start, NYIELD);
+}
+
+static unsigned int
+bench_yield_pong(void) {
+    int i, pid;
+    if ((pid = fork()) == 0) {
+        for (i = 0; i < NYIELD; i ++) {
+            yield();
+        }
+        exit(0);
+    }
+    assert(pid > 0);
+    // 先让子进程跑起来
+    yield();
+    uint64_t start = cycles();
+    for (i = 0; i < NYIELD; i ++) {
+        yield();
+    }
+    uint64_t total = cycles() - start;
+    assert(waitpid(pid, NULL) == 0);
+    // 每轮父子进程各切换一次
+    return per_op(total, NYIELD * 2);
+}
+
+// 等轮到自己，再把令牌交给另一个线程，然后在条件变量上睡眠
+static int
+pong(void *arg) {
+    int me = (int)arg, i;
+    mutex_lock(&pong_mutex);
+    for (i = 0; i < NWAIT; i ++) {
+        while (turn != me) {
+            cond_wait(pong_cond + me, &pong_mutex);
+        }
+        turn = !me;
+        cond_signal(pong_cond + !me);
+    }
+    mutex_unlock(&pong_mutex);
+    return 0;
+}
+
+static unsigned int
+bench_wait_wakeup(void) {
+    thread_t t;
+    int code;
+    turn = 0;
+    assert(thread_create(&t, pong, (void *)1, pong_stack, STACK_SIZE) == 0);
+    uint64_t start = cycles();
+    pong((void *)0);
+    assert(thread_join(&t, &code) == 0 && code == 0);
+    // 每轮两个线程各被唤醒一次
+    return per_op(cycles() - start, NWAIT * 2);
+}
+
+int
+main(void) {
+    unsigned int online;
+    assert(sched_getaffinity(0, &online) == 0);
+    int cpu = 0;
+    while (!(online & (1 << cpu))) {
+        cpu ++;
+    }
+    assert(sched_setaffinity(0, 1 << cpu) == 0);
+
+    cprintf("yield-self:  %u cycles per yield\n", bench_yield_self());
+    cprintf("yield-pong:  %u cycles per switch\n", bench_yield_pong());
+    cprintf("wait-wakeup: %u cycles per wakeup and switch\n", bench_wait_wakeup());
+    cprintf("switchbench pass.\n");
+    return 0;
+}
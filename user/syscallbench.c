@@ -0,0 +1,66 @@
+#include <ulib.h>
+#include <stdio.h>
+#include "libs/x86.h"
+
+/* *
+ * syscallbench - latency of a null system call, in tsc cycles
+ *
+ * getpid does almost nothing in the kernel, so the time of a getpid loop is
+ * mostly the cost of getting into the kernel and back. The loop is run once
+ * with int 0x80 and once with sysenter/sysexit, if the cpu supports it.
+ * */
+
+#define NCALL       100000
+#define NROUND      5
+
+// 平均每次的周期数，总周期数可能超过32位，在64位里做除法
+static unsigned int
+per_op(uint64_t total, unsigned int n) {
+    do_div(total, n);
+    return (unsigned int)total;
+}
+
+// 跑几轮取最快的一轮，减少中断和调度的干扰
+static unsigned int
+bench_getpid(void) {
+    unsigned int best = 0;
+    int r, i, pid = getpid();
+    for (r = 0; r < NROUND; r ++) {
+        uint64_t start = cycles();
+        for (i = 0; i < NCALL; i ++) {
+            assert(getpid() == pid);
+        }
+        unsigned int t = per_op(cycles() - start, NCALL);
+        if (best == 0 || t < best) {
+            best = t;
+        }
+    }
+    return best;
+}
+
+int
+main(void) {
+    bool old = use_sysenter(0);
+    unsigned int t_int = bench_getpid();
+    cprintf("int 0x80:  %u cycles per getpid\n", t_int);
+
+    // 再打开一次，返回的就是上一次有没有打开成功
+    use_sysenter(1);
+    if (use_sysenter(1)) {
+        unsigned int t_sysenter = bench_getpid();
+        cprintf("sysenter:  %u cycles per getpid\n", t_sysenter);
+        // fork出的子进程也得能用sysenter返回
+        int pid;
+        if ((pid = fork()) == 0) {
+            exit(getpid());
+        }
+        int code;
+        assert(pid > 0 && waitpid(pid, &code) == 0 && code == pid);
+    } else {
+        cprintf("sysenter:  not supported by this cpu\n");
+    }
+
+    use_sysenter(old);
+    cprintf("syscallbench pass.\n");
+    return 0;
+}
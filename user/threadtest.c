@@ -0,0 +1,76 @@
+#include <ulib.h>
+#include <stdio.h>
+
+/* *
+ * threadtest - threads created by thread_create share the address space
+ *
+ * NTHREAD threads each add their own number to a global array and bump a
+ * shared counter, and the main thread checks the writes after joining them.
+ * Then a thread calls exit() while others are spinning, which must take the
+ * whole thread group down with its exit code, tested in a forked child so
+ * we survive it.
+ * */
+
+#define NTHREAD     4
+#define STACK_SIZE  4096
+#define NLOOP       1000
+
+static char stacks[NTHREAD][STACK_SIZE];
+static volatile int slots[NTHREAD];
+static volatile int counter;
+
+static int
+adder(void *arg) {
+    int n = (int)arg, i;
+    for (i = 0; i < NLOOP; i ++) {
+        slots[n] ++;
+        // 没有原子操作，只有让出CPU前后的计数是可靠的
+        if (i % 100 == 0) {
+            yield();
+        }
+    }
+    counter ++;
+    return n + 100;
+}
+
+static int
+spinner(void *arg) {
+    while (1) {
+        yield();
+    }
+    return 0;
+}
+
+static int
+killer(void *arg) {
+    sleep(10);
+    exit(42);
+    return 0;
+}
+
+int
+main(void) {
+    thread_t threads[NTHREAD];
+    int i, code, pid;
+
+    for (i = 0; i < NTHREAD; i ++) {
+        assert(thread_create(threads + i, adder, (void *)i, stacks[i], STACK_SIZE) == 0);
+    }
+    for (i = 0; i < NTHREAD; i ++) {
+        assert(thread_join(threads + i, &code) == 0 && code == i + 100);
+        assert(slots[i] == NLOOP);
+    }
+    cprintf("%d threads joined, counter %d\n", NTHREAD, counter);
+
+    // 任何一个线程调用exit，整个线程组都退出
+    if ((pid = fork()) == 0) {
+        thread_t t;
+        assert(thread_create(&t, spinner, NULL, stacks[0], STACK_SIZE) == 0);
+        assert(thread_create(&t, killer, NULL, stacks[1], STACK_SIZE) == 0);
+        spinner(NULL);
+    }
+    // 主线程是被杀掉的，但父进程拿到的是整个线程组的退出码
+    assert(pid > 0 && waitpid(pid, &code) == 0 && code == 42);
+    cprintf("threadtest pass.\n");
+    return 0;
+}
@@ -0,0 +1,7 @@
+#include <ulib.h>
+
+// 什么也不做的程序，用来测创建进程和装入程序的开销
+int
+main(void) {
+    return 0;
+}